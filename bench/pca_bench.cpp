@@ -0,0 +1,460 @@
+// Headless benchmark of PCA.h: runs each algorithm, normalization and thread count on data sets
+// and prints per-phase timings, peak memory and throughput as JSON, e.g. to size jobs on a server
+// Call like:
+//   pca_bench --data ../test/data/iris_data.json --synthetic 1000000x50 --threads 1,8 --output bench.json
+// Run pca_bench --help for all options
+
+#include <nlohmann/json.hpp>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <optional>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+#include "PCA.h"
+
+namespace fs = std::filesystem;
+using json = nlohmann::ordered_json;
+using Clock = std::chrono::steady_clock;
+
+/// /////// ///
+/// OPTIONS ///
+/// /////// ///
+
+struct DataSet
+{
+    std::string         name;
+    std::vector<float>  values;     /** Row-major, num_points x num_dims */
+    size_t              num_points = 0;
+    size_t              num_dims = 0;
+};
+
+struct Options
+{
+    std::vector<fs::path>                       dataFiles;
+    std::vector<std::array<size_t, 2>>          synthetic;
+    std::vector<math::PCA_ALG>                  algorithms = { math::PCA_ALG::COV, math::PCA_ALG::SVD, math::PCA_ALG::RANDOMIZED };
+    std::vector<math::DATA_NORM>                norms = { math::DATA_NORM::NONE, math::DATA_NORM::MEAN, math::DATA_NORM::MINMAX };
+    std::vector<int>                            threads;
+    size_t                                      num_comps = 2;
+    size_t                                      repeats = 1;
+    math::SolverParams                          solverParams;
+    std::optional<fs::path>                     output;
+};
+
+static void printUsage()
+{
+    std::cerr <<
+        "Usage: pca_bench [options]\n"
+        "  --data <file.json>           Data set described by a json file next to its .bin, like those in test/data, may be repeated\n"
+        "  --synthetic <rows>x<dims>    Synthetic data set with a decaying spectrum, may be repeated, default 100000x50 if no data is given\n"
+        "  --algorithms <list>          Comma-separated subset of cov,svd,randomized, default all\n"
+        "  --norms <list>               Comma-separated subset of none,mean,minmax, default all\n"
+        "  --threads <list>             Comma-separated OpenMP thread counts, default 1 and all cores\n"
+        "  --components <k>             Number of components, default 2\n"
+        "  --repeats <r>                Runs per configuration, default 1\n"
+        "  --precision <single|mixed>   Precision of the covariance algorithm, default single\n"
+        "  --output <file.json>         Write the results to a file instead of stdout\n";
+}
+
+static std::vector<std::string> splitList(const std::string& list)
+{
+    std::vector<std::string> items;
+    std::stringstream stream(list);
+    for (std::string item; std::getline(stream, item, ',');)
+        if (!item.empty())
+            items.push_back(item);
+    return items;
+}
+
+static std::optional<Options> parseOptions(int argc, char** argv)
+{
+    Options options;
+
+    for (int i = 1; i < argc; i++)
+    {
+        const std::string arg = argv[i];
+
+        if (arg == "--help" || arg == "-h")
+            return std::nullopt;
+
+        if (i + 1 >= argc)
+        {
+            std::cerr << "pca_bench: missing value of " << arg << std::endl;
+            return std::nullopt;
+        }
+
+        const std::string value = argv[++i];
+
+        if (arg == "--data")
+            options.dataFiles.emplace_back(value);
+        else if (arg == "--synthetic")
+        {
+            const size_t pos = value.find('x');
+            if (pos == std::string::npos)
+            {
+                std::cerr << "pca_bench: synthetic size must be <rows>x<dims>, not " << value << std::endl;
+                return std::nullopt;
+            }
+            options.synthetic.push_back({ std::stoull(value.substr(0, pos)), std::stoull(value.substr(pos + 1)) });
+        }
+        else if (arg == "--algorithms")
+        {
+            options.algorithms.clear();
+            for (const std::string& item : splitList(value))
+            {
+                if (item == "cov")              options.algorithms.push_back(math::PCA_ALG::COV);
+                else if (item == "svd")         options.algorithms.push_back(math::PCA_ALG::SVD);
+                else if (item == "randomized")  options.algorithms.push_back(math::PCA_ALG::RANDOMIZED);
+                else
+                {
+                    std::cerr << "pca_bench: unknown algorithm " << item << std::endl;
+                    return std::nullopt;
+                }
+            }
+        }
+        else if (arg == "--norms")
+        {
+            options.norms.clear();
+            for (const std::string& item : splitList(value))
+            {
+                if (item == "none")             options.norms.push_back(math::DATA_NORM::NONE);
+                else if (item == "mean")        options.norms.push_back(math::DATA_NORM::MEAN);
+                else if (item == "minmax")      options.norms.push_back(math::DATA_NORM::MINMAX);
+                else
+                {
+                    std::cerr << "pca_bench: unknown normalization " << item << std::endl;
+                    return std::nullopt;
+                }
+            }
+        }
+        else if (arg == "--threads")
+        {
+            for (const std::string& item : splitList(value))
+                options.threads.push_back(std::max(std::stoi(item), 1));
+        }
+        else if (arg == "--components")
+            options.num_comps = std::stoull(value);
+        else if (arg == "--repeats")
+            options.repeats = std::max<size_t>(std::stoull(value), 1);
+        else if (arg == "--precision")
+            options.solverParams.precision = (value == "mixed") ? math::PRECISION::MIXED : math::PRECISION::SINGLE;
+        else if (arg == "--output")
+            options.output = fs::path(value);
+        else
+        {
+            std::cerr << "pca_bench: unknown option " << arg << std::endl;
+            return std::nullopt;
+        }
+    }
+
+    if (options.dataFiles.empty() && options.synthetic.empty())
+        options.synthetic.push_back({ 100'000, 50 });
+
+    if (options.threads.empty())
+    {
+        options.threads.push_back(1);
+#ifdef _OPENMP
+        if (omp_get_max_threads() > 1)
+            options.threads.push_back(omp_get_max_threads());
+#endif
+    }
+
+    return options;
+}
+
+/// //// ///
+/// DATA ///
+/// //// ///
+
+// Reads the .bin that the json file refers to, relative to the json file or its parent directory like in test/data
+static std::optional<DataSet> loadDataSet(const fs::path& jsonFile)
+{
+    std::ifstream jsonStream(jsonFile);
+    if (!jsonStream.is_open())
+    {
+        std::cerr << "pca_bench: unable to open " << jsonFile << std::endl;
+        return std::nullopt;
+    }
+
+    const json meta = json::parse(jsonStream);
+    const fs::path binaryFile = meta.at("Binary file").get<std::string>();
+
+    DataSet dataSet;
+    dataSet.name = jsonFile.stem().string();
+    dataSet.num_points = meta.at("Data points").get<size_t>();
+    dataSet.num_dims = meta.at("Dimensions").get<size_t>();
+
+    fs::path binaryPath = jsonFile.parent_path() / binaryFile;
+    if (!fs::exists(binaryPath))
+        binaryPath = jsonFile.parent_path().parent_path() / binaryFile;
+    if (!fs::exists(binaryPath))
+        binaryPath = jsonFile.parent_path() / binaryFile.filename();
+
+    std::ifstream binaryStream(binaryPath, std::ios::in | std::ios::binary);
+    if (!binaryStream.is_open())
+    {
+        std::cerr << "pca_bench: unable to open " << binaryPath << std::endl;
+        return std::nullopt;
+    }
+
+    dataSet.values.resize(dataSet.num_points * dataSet.num_dims);
+    binaryStream.read(reinterpret_cast<char*>(dataSet.values.data()), static_cast<std::streamsize>(dataSet.values.size() * sizeof(float)));
+
+    if (static_cast<size_t>(binaryStream.gcount()) != dataSet.values.size() * sizeof(float))
+    {
+        std::cerr << "pca_bench: " << binaryPath << " has fewer values than " << jsonFile << " describes" << std::endl;
+        return std::nullopt;
+    }
+
+    return dataSet;
+}
+
+// Gaussian data whose standard deviation decays per dimension, such that the spectrum is not flat
+static DataSet syntheticDataSet(const size_t num_points, const size_t num_dims)
+{
+    DataSet dataSet;
+    dataSet.name = "synthetic_" + std::to_string(num_points) + "x" + std::to_string(num_dims);
+    dataSet.num_points = num_points;
+    dataSet.num_dims = num_dims;
+    dataSet.values.resize(num_points * num_dims);
+
+    constexpr int64_t block_rows = 4096;
+    const int64_t num_blocks = (static_cast<int64_t>(num_points) + block_rows - 1) / block_rows;
+
+    // one generator per block, the data does not depend on the number of threads
+#pragma omp parallel for
+    for (int64_t block = 0; block < num_blocks; block++)
+    {
+        std::mt19937 gen(static_cast<uint32_t>(block));
+        std::normal_distribution<float> dist(0.0f, 1.0f);
+
+        const size_t row_end = std::min(num_points, static_cast<size_t>((block + 1) * block_rows));
+        for (size_t row = static_cast<size_t>(block * block_rows); row < row_end; row++)
+            for (size_t col = 0; col < num_dims; col++)
+                dataSet.values[row * num_dims + col] = dist(gen) / (1.0f + 0.5f * static_cast<float>(col)) + 0.01f * static_cast<float>(col);
+    }
+
+    return dataSet;
+}
+
+/// ////// ///
+/// MEMORY ///
+/// ////// ///
+
+// Resets the peak resident set size of the process where the OS allows it, see peakResidentBytes
+static bool resetPeakResidentBytes()
+{
+#ifdef __linux__
+    std::ofstream clearRefs("/proc/self/clear_refs");
+    clearRefs << "5";
+    return clearRefs.good();
+#else
+    return false;
+#endif
+}
+
+// Peak resident set size since the last successful reset, otherwise since the start of the process
+static size_t peakResidentBytes()
+{
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+        return counters.PeakWorkingSetSize;
+    return 0;
+#else
+#ifdef __linux__
+    std::ifstream status("/proc/self/status");
+    for (std::string line; std::getline(status, line);)
+        if (line.rfind("VmHWM:", 0) == 0)
+            return std::stoull(line.substr(6)) * 1024;
+#endif
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+    return static_cast<size_t>(usage.ru_maxrss);
+#else
+    return static_cast<size_t>(usage.ru_maxrss) * 1024;
+#endif
+#endif
+}
+
+/// ///////// ///
+/// BENCHMARK ///
+/// ///////// ///
+
+static const char* algorithmName(math::PCA_ALG alg)
+{
+    switch (alg)
+    {
+    case math::PCA_ALG::COV:        return "cov";
+    case math::PCA_ALG::SVD:        return "svd";
+    case math::PCA_ALG::RANDOMIZED: return "randomized";
+    }
+    return "";
+}
+
+static const char* normName(math::DATA_NORM norm)
+{
+    switch (norm)
+    {
+    case math::DATA_NORM::NONE:     return "none";
+    case math::DATA_NORM::MEAN:     return "mean";
+    case math::DATA_NORM::MINMAX:   return "minmax";
+    }
+    return "";
+}
+
+static const char* phaseName(math::PHASE phase)
+{
+    switch (phase)
+    {
+    case math::PHASE::EXTRACT:      return "extract";
+    case math::PHASE::NORMALIZE:    return "normalize";
+    case math::PHASE::CENTER:       return "center";
+    case math::PHASE::DECOMPOSE:    return "decompose";
+    case math::PHASE::PROJECT:      return "project";
+    case math::PHASE::ORIENT:       return "orient";
+    case math::PHASE::PUBLISH:      return "publish";
+    }
+    return "";
+}
+
+static json runOnce(const DataSet& dataSet, math::PCA_ALG alg, math::DATA_NORM norm, int num_threads, const Options& options)
+{
+#ifdef _OPENMP
+    omp_set_num_threads(num_threads);
+#endif
+
+    // a phase lasts from its first progress report until the first report of another phase
+    std::vector<std::pair<math::PHASE, Clock::time_point>> phaseStarts;
+    math::SolverParams solverParams = options.solverParams;
+    solverParams.progress = [&phaseStarts](math::PHASE phase, float) {
+        if (phaseStarts.empty() || phaseStarts.back().first != phase)
+            phaseStarts.emplace_back(phase, Clock::now());
+        };
+
+    math::SolverStatus status;
+    solverParams.status = &status;
+
+    const size_t num_comps = std::min({ options.num_comps, dataSet.num_points, dataSet.num_dims });
+    std::vector<float> pca_out(dataSet.num_points * num_comps);
+
+    const bool peakReset = resetPeakResidentBytes();
+
+    const auto start = Clock::now();
+    const bool success = math::pcaInto<float>(dataSet.values, dataSet.num_dims, pca_out, num_comps, alg, norm, /* stdOrientation = */ true, solverParams);
+    const auto end = Clock::now();
+
+    const auto milliseconds = [](Clock::duration duration) { return std::chrono::duration<double, std::milli>(duration).count(); };
+    const double total_ms = milliseconds(end - start);
+
+    json phases = json::object();
+    for (size_t i = 0; i < phaseStarts.size(); i++)
+    {
+        const Clock::time_point phaseEnd = (i + 1 < phaseStarts.size()) ? phaseStarts[i + 1].second : end;
+        phases[phaseName(phaseStarts[i].first)] = phases.value(phaseName(phaseStarts[i].first), 0.0) + milliseconds(phaseEnd - phaseStarts[i].second);
+    }
+
+    const double seconds = total_ms / 1000.0;
+    const double bytes = static_cast<double>(dataSet.values.size() * sizeof(float));
+
+    json run;
+    run["data"] = dataSet.name;
+    run["points"] = dataSet.num_points;
+    run["dimensions"] = dataSet.num_dims;
+    run["components"] = num_comps;
+    run["algorithm"] = algorithmName(alg);
+    run["norm"] = normName(norm);
+    run["threads"] = num_threads;
+    run["success"] = success;
+    run["converged"] = status.converged;
+    if (!status.error.empty())
+        run["error"] = status.error;
+    run["total_ms"] = total_ms;
+    run["phases_ms"] = phases;
+    run["peak_rss_bytes"] = peakResidentBytes();
+    run["peak_rss_is_per_run"] = peakReset;
+    run["estimated_working_bytes"] = math::estimateWorkingBytes<float>(dataSet.num_points, dataSet.num_dims, num_comps, alg, solverParams);
+    run["points_per_second"] = seconds > 0.0 ? static_cast<double>(dataSet.num_points) / seconds : 0.0;
+    run["megabytes_per_second"] = seconds > 0.0 ? bytes / (1024.0 * 1024.0) / seconds : 0.0;
+
+    return run;
+}
+
+int main(int argc, char** argv)
+{
+    const std::optional<Options> options = parseOptions(argc, argv);
+    if (!options)
+    {
+        printUsage();
+        return 1;
+    }
+
+#ifdef _OPENMP
+    const int maxThreads = omp_get_max_threads();
+#else
+    const int maxThreads = 1;
+#endif
+
+    std::vector<DataSet> dataSets;
+    json loads = json::array();
+
+    for (const fs::path& dataFile : options->dataFiles)
+    {
+        const auto start = Clock::now();
+        std::optional<DataSet> dataSet = loadDataSet(dataFile);
+        if (!dataSet)
+            return 1;
+        loads.push_back({ { "data", dataSet->name }, { "load_ms", std::chrono::duration<double, std::milli>(Clock::now() - start).count() } });
+        dataSets.push_back(std::move(*dataSet));
+    }
+
+    for (const auto& [num_points, num_dims] : options->synthetic)
+    {
+        const auto start = Clock::now();
+        dataSets.push_back(syntheticDataSet(num_points, num_dims));
+        loads.push_back({ { "data", dataSets.back().name }, { "load_ms", std::chrono::duration<double, std::milli>(Clock::now() - start).count() } });
+    }
+
+    json runs = json::array();
+    for (const DataSet& dataSet : dataSets)
+        for (const math::PCA_ALG alg : options->algorithms)
+            for (const math::DATA_NORM norm : options->norms)
+                for (const int num_threads : options->threads)
+                    for (size_t repeat = 0; repeat < options->repeats; repeat++)
+                    {
+                        std::cerr << "pca_bench: " << dataSet.name << " " << algorithmName(alg) << " " << normName(norm) << " " << num_threads << " threads" << std::endl;
+                        runs.push_back(runOnce(dataSet, alg, norm, num_threads, *options));
+                    }
+
+    json result;
+    result["max_threads"] = maxThreads;
+    result["loads"] = loads;
+    result["runs"] = runs;
+
+    if (options->output)
+    {
+        std::ofstream outputStream(*options->output);
+        outputStream << result.dump(4) << std::endl;
+    }
+    else
+        std::cout << result.dump(4) << std::endl;
+
+    return 0;
+}
@@ -1,21 +1,34 @@
 #ifndef PCA_H
 #define PCA_H
 
+#include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <chrono>
+#include <cmath>
 #include <cstdint>
+#include <cstring>
+#include <functional>
 #include <iostream>
 #include <limits>
 #include <numeric>
+#include <random>
+#include <span>
 #include <stdexcept>
 #include <string>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
 #include <Eigen/Core>
 #include <Eigen/Eigenvalues>
+#include <Eigen/QR>
 #include <Eigen/SVD>
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 namespace utils {
 
     /// ////// ///
@@ -53,53 +66,220 @@ namespace math {
     enum class PCA_ALG {
         SVD,    // Use singular value decomposition, Eigen::BDCSVD
         COV,    // Compute eigenvalues of covariance matrix of data, Eigen::SelfAdjointEigenSolver
+        RANDOMIZED, // Randomized truncated singular value decomposition, cost scales with num_comp instead of min(num_row, num_col)
+    };
+
+    enum class PRECISION {
+        SINGLE,     // accumulate and decompose in float
+        MIXED,      // COV: data stays in float, the covariance matrix is accumulated and decomposed in double
+    };
+
+    enum class FIT_SAMPLE {
+        ALL_POINTS, // decompose all rows
+        UNIFORM,    // decompose a uniform sample of the rows, see uniformSample
+        STRATIFIED, // decompose a sample in which each stratum is represented in proportion to its size, see stratifiedSample
+    };
+
+    // Cooperative cancellation of a running pca, cancel() may be called from any thread
+    // The kernels poll the token between chunks of rows and solver iterations and throw Cancelled
+    class CancellationToken {
+    public:
+        void cancel() { _cancelled.store(true, std::memory_order_relaxed); }
+        void reset() { _cancelled.store(false, std::memory_order_relaxed); }
+        bool isCancelled() const { return _cancelled.load(std::memory_order_relaxed); }
+
+    private:
+        std::atomic<bool> _cancelled = false;
+    };
+
+    // Thrown by the kernels once their CancellationToken is cancelled, all working memory is released during unwinding
+    class Cancelled : public std::runtime_error {
+    public:
+        Cancelled() : std::runtime_error("cancelled") {}
+    };
+
+    inline bool isCancelled(const CancellationToken* cancel)
+    {
+        return cancel != nullptr && cancel->isCancelled();
+    }
+
+    // Call outside of OpenMP parallel regions only, inside them skip the remaining work with isCancelled
+    inline void throwIfCancelled(const CancellationToken* cancel)
+    {
+        if (isCancelled(cancel))
+            throw Cancelled();
+    }
+
+    // Phases of a pca run, EXTRACT and PUBLISH are reported by the caller that owns the data
+    enum class PHASE {
+        EXTRACT,    // copy the input data
+        NORMALIZE,  // column statistics for normalization and centering
+        CENTER,     // normalize and center the working matrix
+        DECOMPOSE,  // scatter matrix accumulation and decomposition
+        PROJECT,    // project the data onto the principal components
+        ORIENT,     // standard orientation of the projection
+        PUBLISH,    // hand the projection over to its consumer
+    };
+
+    // Progress of a pca run: the current phase and the completed fraction of it in [0, 1]
+    // Invoked from the thread that called pca, never from OpenMP worker threads, and often: keep it cheap
+    using ProgressCallback = std::function<void(PHASE phase, float fraction)>;
+
+    inline void reportProgress(const ProgressCallback& progress, const PHASE phase, const float fraction)
+    {
+        if (progress)
+            progress(phase, fraction);
+    }
+
+    // Counts the completed chunks of a parallel loop, only the thread that started the loop reports them
+    class ChunkProgress {
+    public:
+        ChunkProgress(const ProgressCallback& progress, const PHASE phase, const int64_t num_chunks) :
+            _progress(progress), _phase(phase), _num_chunks(std::max<int64_t>(num_chunks, 1))
+        {
+            reportProgress(_progress, _phase, 0.0f);
+        }
+
+        void chunkDone()
+        {
+            if (!_progress)
+                return;
+
+            const int64_t done = _done.fetch_add(1, std::memory_order_relaxed) + 1;
+
+#ifdef _OPENMP
+            if (omp_get_thread_num() != 0)
+                return;
+#endif
+
+            _progress(_phase, static_cast<float>(done) / static_cast<float>(_num_chunks));
+        }
+
+        void finish() { reportProgress(_progress, _phase, 1.0f); }
+
+    private:
+        const ProgressCallback& _progress;
+        const PHASE             _phase;
+        const int64_t           _num_chunks;
+        std::atomic<int64_t>    _done = 0;
+    };
+
+    // Outcome of a computation that its return value does not tell, see SolverParams::status
+    struct SolverStatus {
+        bool converged = true;              // false if the partial eigensolver stopped at maxIterations, its eigenpairs are approximate
+        std::string error;                  // reason of the last failure, empty if none
     };
 
+    // Parameters of the iterative and randomized solvers
+    struct SolverParams {
+        size_t oversampling = 10;           // RANDOMIZED and partial eigensolver: number of vectors in addition to num_comp
+        size_t powerIterations = 4;         // RANDOMIZED: number of power iterations, improves accuracy for slowly decaying spectra
+        uint32_t seed = 0;                  // seed for the random number generator, makes results reproducible
+        float tolerance = 1e-4f;            // partial eigensolver: converged once all residuals ||C v - l v|| <= tolerance * l_max
+        size_t maxIterations = 500;         // partial eigensolver: iteration cap
+        float partialEigenFraction = 0.1f;  // COV: only compute the top eigenpairs if num_comp + oversampling <= partialEigenFraction * num_col, 0 disables
+        PRECISION precision = PRECISION::SINGLE; // COV: precision of the covariance accumulation and eigendecomposition
+        size_t refinementSteps = 0;         // COV: subspace iteration steps that refine the eigenvectors after the eigendecomposition
+        float varianceFraction = 0.0f;      // in (0, 1): num_comp is an upper bound, the fewest components that explain this fraction of the total variance are computed
+        size_t initialComponents = 8;       // varianceFraction: components of the first round, doubled until the fraction is explained
+        const CancellationToken* cancel = nullptr; // polled by pca and all its kernels, nullptr if the computation cannot be cancelled
+        ProgressCallback progress;          // progress of pca and its kernels, may be empty
+        SolverStatus* status = nullptr;     // filled by pca and its kernels, nullptr if the caller does not need it
+    };
+
+    // Record the reason of a failure in status, the library does not log
+    inline void setError(SolverStatus* status, const std::string& error)
+    {
+        if (status)
+            status->error = error;
+    }
+
+    inline void setError(const SolverParams& params, const std::string& error)
+    {
+        setError(params.status, error);
+    }
+
     /// ////////// ///
     /// CONVERSION ///
     /// ////////// ///
 
-    template<class T>
-    inline std::vector<T> convertEigenMatrixToStdVector(Eigen::Matrix<T, -1, -1> mat) {
+    // Row-major layout of the input data: each row corresponds to one data point, [p0d0, p0d1, ..., p1d0, p1d1, ...]
+    template<typename Scalar>
+    using RowMajorMatrix = Eigen::Matrix<Scalar, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>;
 
-        const Eigen::StorageOptions StorageOrder = mat.IsRowMajor ? Eigen::RowMajor : Eigen::ColMajor;
+    using RowMajorMatrixXf = RowMajorMatrix<float>;
+    using RowMajorMatrixXd = RowMajorMatrix<double>;
 
-        // by default Eigen uses column-major storage order
-        if constexpr (StorageOrder == Eigen::ColMajor)
-        {
-            mat.transposeInPlace();
-        }
+    // View row-major data as an Eigen matrix without copying
+    template<typename Scalar>
+    inline Eigen::Map<const RowMajorMatrix<Scalar>> mapRowMajor(std::span<const Scalar> data_in, const size_t num_dims)
+    {
+        return { data_in.data(), static_cast<Eigen::Index>(data_in.size() / num_dims), static_cast<Eigen::Index>(num_dims) };
+    }
 
-        return { mat.data(), mat.data() + mat.size() };
+    template<typename Scalar>
+    inline Eigen::Map<const RowMajorMatrix<Scalar>> mapRowMajor(const std::vector<Scalar>& data_in, const size_t num_dims)
+    {
+        return mapRowMajor(std::span<const Scalar>(data_in), num_dims);
     }
 
-    inline Eigen::MatrixXf convertStdVectorToEigenMatrix(const std::vector<float>& data_in, const size_t num_dims)
+    // Side length of the square tiles in transposeBlocked, a tile of each of source and destination fits into the L1 cache
+    constexpr int64_t transposeTileSize = 32;
+
+    // Transposes the row-major num_row x num_col buffer src into dst, i.e. dst[col * num_row + row] = src[row * num_col + col]
+    // Equivalently: copies row-major src into column-major dst, or column-major num_col x num_row src into row-major dst
+    // Tiles are copied in parallel, so that both reads and writes stay within a few cache lines per tile row
+    template<class T>
+    inline void transposeBlocked(const T* src, T* dst, const int64_t num_row, const int64_t num_col)
     {
-        const int64_t num_row = data_in.size() / num_dims;
-        const int64_t num_col = num_dims;
+        const int64_t num_row_tiles = (num_row + transposeTileSize - 1) / transposeTileSize;
+        const int64_t num_col_tiles = (num_col + transposeTileSize - 1) / transposeTileSize;
+
+#pragma omp parallel for collapse(2)
+        for (int64_t rowTile = 0; rowTile < num_row_tiles; rowTile++)
+        {
+            for (int64_t colTile = 0; colTile < num_col_tiles; colTile++)
+            {
+                const int64_t rowEnd = std::min(num_row, (rowTile + 1) * transposeTileSize);
+                const int64_t colEnd = std::min(num_col, (colTile + 1) * transposeTileSize);
 
-        if (num_row > std::numeric_limits<int64_t>::max())
-            std::cerr << "PCA::convertStdVectorToEigenMatrix can only handle data with up to std::numeric_limits<int64_t>::max() points" << std::endl;
+                for (int64_t col = colTile * transposeTileSize; col < colEnd; col++)
+                    for (int64_t row = rowTile * transposeTileSize; row < rowEnd; row++)
+                        dst[col * num_row + row] = src[row * num_col + col];
+            }
+        }
+    }
 
-        // convert std vector to Eigen MatrixXf
-        // each row in MatrixXf corresponds to one data point
-        Eigen::MatrixXf data(num_row, num_col);     	// num_rows (data points), num_cols (attributes)
+    // convert to std vector with [p0d0, p0d1, ..., p1d0, p1d1, ..., pNd0, pNd1, ..., pNdM]
+    template<class T, int Options>
+    inline std::vector<T> convertEigenMatrixToStdVector(const Eigen::Matrix<T, -1, -1, Options>& mat) {
 
-        // copy data from vector to matrix
-#ifndef NDEBUG
-#pragma omp parallel for
-#endif // NDEBUG
-        // loop over data points
-        for (int64_t point = 0; point < static_cast<int64_t>(num_row); point++)
+        // row-major storage already has the std vector layout
+        if constexpr ((Options & Eigen::RowMajor) != 0)
+        {
+            return { mat.data(), mat.data() + mat.size() };
+        }
+        else
         {
-            // loop over data point values
-            for (int64_t dim = 0; dim < num_col; dim++)
-                data(point, dim) = data_in[point * num_dims + dim];
+            // by default Eigen uses column-major storage order, i.e. a row-major num_col x num_row buffer
+            std::vector<T> vec(mat.size());
+            transposeBlocked(mat.data(), vec.data(), mat.cols(), mat.rows());
+            return vec;
         }
+    }
 
-        // this would be more concise but only works if data_in is not const
-        // Also, I didn't test this
-        //Eigen::MatrixXf data = Eigen::Map<Eigen::MatrixXf>(&data_in[0], num_row, num_col);
+    template<class T>
+    inline Eigen::Matrix<T, -1, -1> convertStdVectorToEigenMatrix(const std::vector<T>& data_in, const size_t num_dims)
+    {
+        const int64_t num_row = data_in.size() / num_dims;
+        const int64_t num_col = num_dims;
+
+        // convert std vector to column-major Eigen matrix
+        // each row in the matrix corresponds to one data point
+        Eigen::Matrix<T, -1, -1> data(num_row, num_col);     	// num_rows (data points), num_cols (attributes)
+
+        // copy data from the row-major vector to the column-major matrix
+        transposeBlocked(data_in.data(), data.data(), num_row, num_col);
 
         return data;
     }
@@ -122,82 +302,214 @@ namespace math {
         return idx;
     }
 
-    inline Eigen::MatrixXf colwiseZeroMean(const Eigen::MatrixXf& mat) {
+    template<typename Derived>
+    inline Eigen::Matrix<typename Derived::Scalar, -1, -1> colwiseZeroMean(const Eigen::MatrixBase<Derived>& mat) {
         return mat.rowwise() - mat.colwise().mean();
     }
 
+    // Orthonormal basis of the column space of mat, i.e. the thin Q of a QR decomposition
+    template<typename Derived>
+    inline Eigen::Matrix<typename Derived::Scalar, -1, -1> orthonormalBasis(const Eigen::MatrixBase<Derived>& mat)
+    {
+        using Matrix = Eigen::Matrix<typename Derived::Scalar, -1, -1>;
+
+        Eigen::HouseholderQR<Matrix> qr(mat);
+        return qr.householderQ() * Matrix::Identity(mat.rows(), mat.cols());
+    }
+
     // Sign correction to ensure deterministic output:
     // flip each dimension such that the max abs value is positive
     // Is similar to svd_flip from scikit-learn, https://github.com/scikit-learn/scikit-learn
-    inline Eigen::MatrixXf standardOrientation(const Eigen::MatrixXf& mat)
+    template<typename Derived>
+    inline Eigen::Matrix<typename Derived::Scalar, -1, -1> standardOrientation(const Eigen::MatrixBase<Derived>& mat)
     {
+        using Scalar = typename Derived::Scalar;
+
         // columnswise: which row has the max abs value
         // then get the sign of the max abs value
-        Eigen::VectorXf signs(mat.cols());
-        Eigen::VectorXf::Index rowID;
-        for (uint32_t colID = 0; colID < mat.cols(); colID++)
+        Eigen::Matrix<Scalar, -1, 1> signs(mat.cols());
+        Eigen::Index rowID;
+        for (Eigen::Index colID = 0; colID < mat.cols(); colID++)
         {
             mat.col(colID).cwiseAbs().maxCoeff(&rowID);
-            signs[colID] = (mat(rowID, colID) >= 0) ? 1.0f : -1.0f;
+            signs[colID] = (mat(rowID, colID) >= 0) ? Scalar(1) : Scalar(-1);
         }
 
         // flip columns
         return mat.array().rowwise() * signs.transpose().array();
     }
 
-    inline void _normToCol(const Eigen::VectorXf& normFacs, Eigen::MatrixXf& mat)
+    // In-place version of standardOrientation, also flips the corresponding columns of principal_components
+    template<typename Derived, typename DerivedPC>
+    inline void standardOrientationInPlace(Eigen::MatrixBase<Derived>& mat, Eigen::MatrixBase<DerivedPC>& principal_components)
+    {
+        Eigen::Index rowID;
+        for (Eigen::Index colID = 0; colID < mat.cols(); colID++)
+        {
+            mat.col(colID).cwiseAbs().maxCoeff(&rowID);
+            if (mat(rowID, colID) >= 0)
+                continue;
+
+            mat.col(colID) *= typename Derived::Scalar(-1);
+            principal_components.col(colID) *= typename DerivedPC::Scalar(-1);
+        }
+    }
+
+    // Column statistics for the normalization and centering of the data
+    template<typename Scalar = float>
+    struct ColumnStatistics {
+        Eigen::Matrix<Scalar, -1, 1> minVals;   // column minima
+        Eigen::Matrix<Scalar, -1, 1> maxVals;   // column maxima
+        Eigen::VectorXd mean;                   // column means, accumulated in double precision
+    };
+
+    // Number of rows that are processed at once such that a chunk of rows fits into the cache
+    inline Eigen::Index rowChunkSize(const Eigen::Index num_col)
+    {
+        return std::max<Eigen::Index>(64, (Eigen::Index{ 1 } << 16) / std::max<Eigen::Index>(num_col, 1));
+    }
+
+    // Min, max and mean of each column in a single parallel pass over chunks of rows
+    template<typename Derived>
+    inline ColumnStatistics<typename Derived::Scalar> columnStatistics(const Eigen::MatrixBase<Derived>& mat, const CancellationToken* cancel = nullptr, const ProgressCallback& progress = {})
     {
-        const int32_t num_row = static_cast<int32_t>(mat.rows());
-        const int32_t num_col = static_cast<int32_t>(mat.cols());
+        using Scalar = typename Derived::Scalar;
+        using Vector = Eigen::Matrix<Scalar, -1, 1>;
+
+        const Eigen::Index num_row = mat.rows();
+        const Eigen::Index num_col = mat.cols();
+        const Eigen::Index chunk_size = rowChunkSize(num_col);
+        const int64_t num_chunks = (num_row + chunk_size - 1) / chunk_size;
 
-        // divide all values in mat.col(i) by normFacs[i]
-        // return mat_norm.array().rowwise() / normFacs.transpose().array();
+        ColumnStatistics<Scalar> stats{ Vector::Constant(num_col, std::numeric_limits<Scalar>::max()),
+                                        Vector::Constant(num_col, std::numeric_limits<Scalar>::lowest()),
+                                        Eigen::VectorXd::Zero(num_col) };
 
-        // the previous lines don't seem to work, but the following does
-        // there is probably a more elegant way of doing this
-        for (int32_t col = 0; col < num_col; col++)
+        ChunkProgress chunkProgress(progress, PHASE::NORMALIZE, num_chunks);
+
+#pragma omp parallel
         {
-            if (normFacs[col] < 0.0001f) continue;
+            Vector localMin = stats.minVals;
+            Vector localMax = stats.maxVals;
+            Eigen::VectorXd localSum = Eigen::VectorXd::Zero(num_col);
 
-#ifndef NDEBUG
-#pragma omp parallel for
-#endif // NDEBUG
-            for (int32_t row = 0; row < static_cast<int32_t>(num_row); row++)
+#pragma omp for
+            for (int64_t chunk = 0; chunk < num_chunks; chunk++)
+            {
+                if (isCancelled(cancel))
+                    continue;
+
+                const Eigen::Index begin = chunk * chunk_size;
+                const auto rows = mat.middleRows(begin, std::min(chunk_size, num_row - begin));
+
+                localMin = localMin.cwiseMin(rows.colwise().minCoeff().transpose());
+                localMax = localMax.cwiseMax(rows.colwise().maxCoeff().transpose());
+                localSum += rows.template cast<double>().colwise().sum().transpose();
+
+                chunkProgress.chunkDone();
+            }
+
+#pragma omp critical
             {
-                mat(row, col) /= normFacs[col];
+                stats.minVals = stats.minVals.cwiseMin(localMin);
+                stats.maxVals = stats.maxVals.cwiseMax(localMax);
+                stats.mean += localSum;
             }
         }
 
+        throwIfCancelled(cancel);
+        chunkProgress.finish();
+
+        stats.mean /= static_cast<double>(std::max<Eigen::Index>(num_row, 1));
+
+        return stats;
     }
 
-    // https://en.wikipedia.org/wiki/Feature_scaling#Mean_normalization
-    inline Eigen::MatrixXf meanNormalization(const Eigen::MatrixXf& mat)
+    // Column scaling of the normalization: (max - min) for MEAN and MINMAX, one for NONE and (nearly) constant columns
+    template<typename DerivedMin, typename DerivedMax>
+    inline Eigen::Matrix<typename DerivedMin::Scalar, -1, 1> normalizationFactors(const Eigen::MatrixBase<DerivedMin>& minVals, const Eigen::MatrixBase<DerivedMax>& maxVals, const DATA_NORM norm)
+    {
+        using Scalar = typename DerivedMin::Scalar;
+        using Vector = Eigen::Matrix<Scalar, -1, 1>;
+
+        Vector normFacs = Vector::Ones(minVals.size());
+
+        if (norm == DATA_NORM::NONE)
+            return normFacs;
+
+        const Vector range = maxVals - minVals;
+        for (Eigen::Index col = 0; col < range.size(); col++)
+            if (range[col] >= Scalar(0.0001))
+                normFacs[col] = range[col];
+
+        return normFacs;
+    }
+
+    // Writes (mat - shift) / normFacs column-wise into out in a single parallel pass over chunks of rows
+    // mat may have either storage order, out is column-major with the scalar type of mat
+    template<typename Derived>
+    inline void shiftAndScale(const Eigen::MatrixBase<Derived>& mat, const Eigen::Matrix<typename Derived::Scalar, -1, 1>& shift, const Eigen::Matrix<typename Derived::Scalar, -1, 1>& normFacs, Eigen::Matrix<typename Derived::Scalar, -1, -1>& out, const CancellationToken* cancel = nullptr, const ProgressCallback& progress = {})
     {
-        // center around mean per attribute
-        Eigen::MatrixXf mat_norm = colwiseZeroMean(mat);
+        using Scalar = typename Derived::Scalar;
+
+        const Eigen::Index num_row = mat.rows();
+        const Eigen::Index chunk_size = rowChunkSize(mat.cols());
+        const int64_t num_chunks = (num_row + chunk_size - 1) / chunk_size;
+
+        const Eigen::Matrix<Scalar, 1, -1> shiftRow = shift.transpose();
+        const Eigen::Matrix<Scalar, -1, 1> invNormFacs = normFacs.cwiseInverse();
+
+        out.resize(num_row, mat.cols());
+
+        ChunkProgress chunkProgress(progress, PHASE::CENTER, num_chunks);
+
+#pragma omp parallel for
+        for (int64_t chunk = 0; chunk < num_chunks; chunk++)
+        {
+            if (isCancelled(cancel))
+                continue;
+
+            const Eigen::Index begin = chunk * chunk_size;
+            const Eigen::Index len = std::min(chunk_size, num_row - begin);
+            out.middleRows(begin, len).noalias() = (mat.middleRows(begin, len).rowwise() - shiftRow) * invNormFacs.asDiagonal();
+
+            chunkProgress.chunkDone();
+        }
 
-        // compute with (max - min) factors
-        Eigen::VectorXf normFacs = mat.colwise().maxCoeff() - mat.colwise().minCoeff();
+        throwIfCancelled(cancel);
+        chunkProgress.finish();
+    }
+
+    // Normalizes and centers mat into out, one statistics pass over mat and one pass writing out
+    // After centering, MEAN and MINMAX normalization are identical: (x - mean) / (max - min)
+    template<typename Derived>
+    inline void normalizeAndCenter(const Eigen::MatrixBase<Derived>& mat, const DATA_NORM norm, Eigen::Matrix<typename Derived::Scalar, -1, -1>& out)
+    {
+        const auto stats = columnStatistics(mat);
+        shiftAndScale(mat, stats.mean.template cast<typename Derived::Scalar>(), normalizationFactors(stats.minVals, stats.maxVals, norm), out);
+    }
 
-        // norm with (max - min) factors:
-        _normToCol(normFacs, mat_norm);
+    // https://en.wikipedia.org/wiki/Feature_scaling#Mean_normalization
+    template<typename Derived>
+    inline Eigen::Matrix<typename Derived::Scalar, -1, -1> meanNormalization(const Eigen::MatrixBase<Derived>& mat)
+    {
+        // center around mean per attribute and norm with (max - min) factors
+        Eigen::Matrix<typename Derived::Scalar, -1, -1> mat_norm;
+        normalizeAndCenter(mat, DATA_NORM::MEAN, mat_norm);
 
         return mat_norm;
     }
 
     // map each column to [0,1]
     // https://en.wikipedia.org/wiki/Feature_scaling#Rescaling_(min-max_normalization)
-    inline Eigen::MatrixXf minMaxNormalization(const Eigen::MatrixXf& mat)
+    template<typename Derived>
+    inline Eigen::Matrix<typename Derived::Scalar, -1, -1> minMaxNormalization(const Eigen::MatrixBase<Derived>& mat)
     {
-        // compute norm factors
-        Eigen::VectorXf minVals = mat.colwise().minCoeff();
-        Eigen::VectorXf normFacs = mat.colwise().maxCoeff().transpose() - minVals;
+        // shift by min per attribute and norm with (max - min) factors
+        const auto stats = columnStatistics(mat);
 
-        // shift all values
-        Eigen::MatrixXf mat_norm = mat.rowwise() - minVals.transpose();
-
-        // norm
-        _normToCol(normFacs, mat_norm);
+        Eigen::Matrix<typename Derived::Scalar, -1, -1> mat_norm;
+        shiftAndScale(mat, stats.minVals, normalizationFactors(stats.minVals, stats.maxVals, DATA_NORM::MINMAX), mat_norm);
 
         return mat_norm;
     }
@@ -223,30 +535,187 @@ namespace math {
     }
 
     // data should be have column-wise zero empirical mean 
-    inline Eigen::MatrixXf pcaSVD(const Eigen::MatrixXf& data, const size_t num_comp)
+    // Optionally returns the num_comp largest singular values of data
+    template<typename Derived>
+    inline Eigen::Matrix<typename Derived::Scalar, -1, -1> pcaSVD(const Eigen::MatrixBase<Derived>& data, const size_t num_comp, Eigen::Matrix<typename Derived::Scalar, -1, 1>* singular_values = nullptr)
     {
-        // compute svd
-        Eigen::BDCSVD<Eigen::MatrixXf, Eigen::ComputeThinV> svd(data);
+        // compute svd, BDCSVD works on its own column-major copy of data regardless of the storage order
+        Eigen::BDCSVD<Eigen::Matrix<typename Derived::Scalar, -1, -1>, Eigen::ComputeThinV> svd(data);
 
         if(svd.info() != Eigen::Success)
             throw (std::runtime_error("pcaSVD failed. Eigen::ComputationInfo " + std::to_string(static_cast<int32_t>(svd.info()))));
 
+        if (singular_values)
+            *singular_values = svd.singularValues().head(num_comp);
+
         return svd.matrixV()(Eigen::placeholders::all, Eigen::seq(0, num_comp - 1));
     }
 
-    // data should be have column-wise zero empirical mean 
-    inline Eigen::MatrixXf pcaCovMat(const Eigen::MatrixXf& data, const size_t num_comp) 
+    // Whether the number of components is chosen by params.varianceFraction instead of fixed
+    inline bool useVarianceFraction(const SolverParams& params)
+    {
+        return params.varianceFraction > 0.0f && params.varianceFraction < 1.0f;
+    }
+
+    // Fewest leading variances, sorted in decreasing order, that sum to at least fraction * totalVariance
+    // All of them if their sum is smaller
+    template<typename Derived>
+    inline size_t numComponentsForVariance(const Eigen::MatrixBase<Derived>& variances, const double totalVariance, const float fraction)
     {
-        // covariance matrix
-        Eigen::MatrixXf covMat = data.transpose() * data;
+        const double target = static_cast<double>(fraction) * totalVariance;
+
+        double cumulative = 0;
+        for (Eigen::Index comp = 0; comp < variances.size(); comp++)
+        {
+            cumulative += static_cast<double>(variances[comp]);
+            if (cumulative >= target)
+                return static_cast<size_t>(comp + 1);
+        }
+
+        return static_cast<size_t>(variances.size());
+    }
+
+    // Whether to use topEigenpairs instead of a full eigendecomposition for a num_col x num_col matrix
+    inline bool usePartialEigensolver(const size_t num_col, const size_t num_comp, const SolverParams& params)
+    {
+        return static_cast<float>(num_comp + params.oversampling) <= params.partialEigenFraction * static_cast<float>(num_col);
+    }
+
+    // Top num_comp eigenpairs of a symmetric positive semi-definite matrix, sorted by decreasing eigenvalue
+    // Block subspace iteration with Rayleigh-Ritz projection, block size num_comp + oversampling
+    // Saad (2011): Numerical Methods for Large Eigenvalue Problems, Algorithm 5.3
+    // The start basis is random, its first columns are taken from start if given, e.g. the eigenvectors of a previous call with fewer components
+    // Returns false if the residuals did not reach params.tolerance within params.maxIterations, the eigenpairs of the last iteration are returned then
+    template<typename Scalar>
+    inline bool topEigenpairs(const Eigen::Matrix<Scalar, -1, -1>& mat, const size_t num_comp, Eigen::Matrix<Scalar, -1, -1>& eigenvectors, Eigen::Matrix<Scalar, -1, 1>& eigenvalues, const SolverParams& params = {}, const Eigen::Matrix<Scalar, -1, -1>* start = nullptr)
+    {
+        using Matrix = Eigen::Matrix<Scalar, -1, -1>;
+
+        const int64_t num_col = mat.cols();
+        const int64_t num_block = std::min<int64_t>(num_comp + params.oversampling, num_col);
+
+        // random start basis
+        std::mt19937 gen(params.seed);
+        std::normal_distribution<float> dist(0.0f, 1.0f);
+        Matrix Q(num_col, num_block);
+        for (int64_t col = 0; col < num_block; col++)
+            for (int64_t row = 0; row < num_col; row++)
+                Q(row, col) = static_cast<Scalar>(dist(gen));
+        if (start)
+            Q.leftCols(std::min<int64_t>(start->cols(), num_block)) = start->leftCols(std::min<int64_t>(start->cols(), num_block));
+        Q = orthonormalBasis(Q);
+
+        Matrix MQ;
+        Eigen::Matrix<Scalar, -1, 1> ritzValues;
+        bool converged = false;
+
+        for (size_t iter = 0; iter < params.maxIterations && !converged; iter++)
+        {
+            throwIfCancelled(params.cancel);
+
+            MQ = mat.template selfadjointView<Eigen::Lower>() * Q;
+
+            // Rayleigh-Ritz: eigendecomposition of the projected num_block x num_block matrix
+            Eigen::SelfAdjointEigenSolver<Matrix> es(Q.transpose() * MQ);
+
+            if (es.info() != Eigen::Success)
+                throw (std::runtime_error("topEigenpairs failed. Eigen::ComputationInfo " + std::to_string(static_cast<int32_t>(es.info()))));
+
+            // eigenvalues are in increasing order, reverse them
+            ritzValues = es.eigenvalues().reverse();
+            const Matrix ritzRotation = es.eigenvectors().rowwise().reverse();
+            Q = Q * ritzRotation;
+            MQ = MQ * ritzRotation;
+
+            // residuals of the wanted Ritz pairs
+            const Scalar scale = std::max(std::abs(ritzValues[0]), std::numeric_limits<Scalar>::min());
+            const Matrix residuals = MQ.leftCols(num_comp) - Q.leftCols(num_comp) * ritzValues.head(num_comp).asDiagonal();
+            converged = residuals.colwise().norm().maxCoeff() <= static_cast<Scalar>(params.tolerance) * scale;
+
+            // power step
+            if (!converged)
+                Q = orthonormalBasis(MQ);
+        }
+
+        if (!converged && params.status)
+            params.status->converged = false;
+
+        eigenvectors = Q.leftCols(num_comp);
+        eigenvalues = ritzValues.head(num_comp);
+
+        return converged;
+    }
+
+    template<typename Scalar>
+    inline void largestEigenpairs(const Eigen::Matrix<Scalar, -1, -1>& mat, const size_t num_comp, Eigen::Matrix<Scalar, -1, -1>& eigenvectors, Eigen::Matrix<Scalar, -1, 1>& eigenvalues, const SolverParams& params = {});
+
+    // Fewest top eigenpairs of a symmetric positive semi-definite matrix whose eigenvalues sum to params.varianceFraction of its trace, at most max_comp
+    // Grows the number of computed eigenpairs from params.initialComponents by doubling, each round starts from the eigenvectors of the previous one
+    // Stops at the first round that explains the fraction, the full spectrum is only computed once the wanted eigenpairs are too many for topEigenpairs
+    template<typename Scalar>
+    inline void eigenpairsForVariance(const Eigen::Matrix<Scalar, -1, -1>& mat, const size_t max_comp, Eigen::Matrix<Scalar, -1, -1>& eigenvectors, Eigen::Matrix<Scalar, -1, 1>& eigenvalues, const SolverParams& params = {})
+    {
+        const double totalVariance = mat.diagonal().template cast<double>().sum();
+        const double target = static_cast<double>(params.varianceFraction) * totalVariance;
+
+        SolverParams fixedParams = params;
+        fixedParams.varianceFraction = 0.0f;
+
+        size_t num_comp = std::clamp<size_t>(params.initialComponents, 1, max_comp);
+        Eigen::Matrix<Scalar, -1, -1> start;
+
+        while (usePartialEigensolver(mat.cols(), num_comp, params))
+        {
+            topEigenpairs(mat, num_comp, eigenvectors, eigenvalues, params, start.size() > 0 ? &start : nullptr);
+
+            if (eigenvalues.template cast<double>().sum() >= target || num_comp == max_comp)
+            {
+                const size_t num_keep = numComponentsForVariance(eigenvalues, totalVariance, params.varianceFraction);
+                eigenvectors = eigenvectors.leftCols(num_keep).eval();
+                eigenvalues = eigenvalues.head(num_keep).eval();
+                return;
+            }
+
+            start = std::move(eigenvectors);
+            num_comp = std::min(2 * num_comp, max_comp);
+        }
+
+        // the wanted eigenpairs are a large part of the spectrum: each subspace iteration step then costs O(num_col^2 * num_block)
+        // and a slowly decaying spectrum needs many steps, so one O(num_col^3) eigendecomposition is cheaper
+        largestEigenpairs(mat, max_comp, eigenvectors, eigenvalues, fixedParams);
+
+        const size_t num_keep = numComponentsForVariance(eigenvalues, totalVariance, params.varianceFraction);
+        eigenvectors = eigenvectors.leftCols(num_keep).eval();
+        eigenvalues = eigenvalues.head(num_keep).eval();
+    }
+
+    // Eigenpairs of a symmetric positive semi-definite matrix that correspond to the num_comp largest eigenvalues, sorted by decreasing eigenvalue
+    // Uses topEigenpairs if num_comp is small compared to the size of mat, a full eigendecomposition otherwise
+    // With params.varianceFraction, num_comp is an upper bound, see eigenpairsForVariance
+    template<typename Scalar>
+    inline void largestEigenpairs(const Eigen::Matrix<Scalar, -1, -1>& mat, const size_t num_comp, Eigen::Matrix<Scalar, -1, -1>& eigenvectors, Eigen::Matrix<Scalar, -1, 1>& eigenvalues, const SolverParams& params)
+    {
+        if (useVarianceFraction(params))
+        {
+            eigenpairsForVariance(mat, num_comp, eigenvectors, eigenvalues, params);
+            return;
+        }
+
+        // only compute the wanted eigenpairs if the matrix is much larger than the number of components
+        if (usePartialEigensolver(mat.cols(), num_comp, params))
+        {
+            topEigenpairs(mat, num_comp, eigenvectors, eigenvalues, params);
+            return;
+        }
 
         // covariance matrices are symmetric, so use appropriate solver
-        Eigen::SelfAdjointEigenSolver <Eigen::MatrixXf> es(covMat);
-        Eigen::VectorXf eigenvalues = es.eigenvalues();
-        Eigen::MatrixXf eigenvectors = es.eigenvectors();
+        throwIfCancelled(params.cancel);
+        Eigen::SelfAdjointEigenSolver<Eigen::Matrix<Scalar, -1, -1>> es(mat);
+        eigenvalues = es.eigenvalues();
+        eigenvectors = es.eigenvectors();
 
         if (es.info() != Eigen::Success)
-            throw (std::runtime_error("pcaCovMat failed. Eigen::ComputationInfo " + std::to_string(static_cast<int32_t>(es.info()))));
+            throw (std::runtime_error("largestEigenpairs failed. Eigen::ComputationInfo " + std::to_string(static_cast<int32_t>(es.info()))));
 
         // sort eigenvalues and save as Eigen::Vector
         auto eigenvalueOrder = argsort(eigenvalues, std::greater{});
@@ -258,86 +727,1276 @@ namespace math {
         eigenvectors = eigenvectors * perm;     // permute columns
         eigenvalues = perm * eigenvalues;
 
-        return eigenvectors(Eigen::placeholders::all, Eigen::seq(0, num_comp - 1));
+        eigenvectors = eigenvectors(Eigen::placeholders::all, Eigen::seq(0, num_comp - 1)).eval();
+        eigenvalues = eigenvalues.head(num_comp).eval();
     }
 
-    inline Eigen::MatrixXf pcaTransform(const Eigen::MatrixXf& data, const Eigen::MatrixXf& principal_components)
+    // Refines approximate top eigenpairs of a symmetric matrix, only the lower triangle of mat is used
+    // Each step is one subspace iteration with Rayleigh-Ritz projection, like topEigenpairs started from the given eigenvectors
+    template<typename Scalar>
+    inline void refineEigenpairs(const Eigen::Matrix<Scalar, -1, -1>& mat, Eigen::Matrix<Scalar, -1, -1>& eigenvectors, Eigen::Matrix<Scalar, -1, 1>& eigenvalues, const size_t steps, const CancellationToken* cancel = nullptr)
     {
-        return data * principal_components;
+        using Matrix = Eigen::Matrix<Scalar, -1, -1>;
+
+        for (size_t step = 0; step < steps; step++)
+        {
+            throwIfCancelled(cancel);
+
+            const Matrix Q = orthonormalBasis(mat.template selfadjointView<Eigen::Lower>() * eigenvectors);
+            Eigen::SelfAdjointEigenSolver<Matrix> es(Q.transpose() * (mat.template selfadjointView<Eigen::Lower>() * Q));
+
+            if (es.info() != Eigen::Success)
+                throw (std::runtime_error("refineEigenpairs failed. Eigen::ComputationInfo " + std::to_string(static_cast<int32_t>(es.info()))));
+
+            eigenvalues = es.eigenvalues().reverse();
+            eigenvectors = Q * es.eigenvectors().rowwise().reverse();
+        }
     }
 
-    inline bool pca(const std::vector<float>& data_in, const size_t num_dims, std::vector<float>& pca_out, size_t& num_comp, const PCA_ALG algorithm = PCA_ALG::SVD, const DATA_NORM norm = DATA_NORM::MINMAX, const bool stdOrientation = true)
+    // Number of threads for the scatter kernel, limited such that the per-thread accumulators fit into maxBytes
+    inline int scatterThreads(const Eigen::Index num_col, const size_t bytesPerValue = sizeof(float), const size_t maxBytes = size_t{ 1 } << 30)
     {
-        // do not transform if data is 1d
-        if (num_dims <= 1)
+#ifdef _OPENMP
+        const size_t bytesPerThread = static_cast<size_t>(num_col) * static_cast<size_t>(num_col) * bytesPerValue;
+        return static_cast<int>(std::clamp<size_t>(maxBytes / std::max<size_t>(bytesPerThread, 1), 1, static_cast<size_t>(omp_get_max_threads())));
+#else
+        return 1;
+#endif
+    }
+
+    // Scatter matrix S = X^T X of X = (mat - shift) / normFacs, only the lower triangle is computed
+    // Symmetric rank-k updates of cache-sized row chunks into per-thread accumulators, which are summed at the end
+    // X is never materialized, each thread only normalizes and centers one chunk at a time
+    // The accumulation uses the Scalar type of shift and normFacs, e.g. double for float data in PRECISION::MIXED
+    template<typename Scalar, typename Derived>
+    inline Eigen::Matrix<Scalar, -1, -1> scatterMatrix(const Eigen::MatrixBase<Derived>& mat, const Eigen::Matrix<Scalar, -1, 1>& shift, const Eigen::Matrix<Scalar, -1, 1>& normFacs, const CancellationToken* cancel = nullptr, const ProgressCallback& progress = {})
+    {
+        using Matrix = Eigen::Matrix<Scalar, -1, -1>;
+
+        const Eigen::Index num_row = mat.rows();
+        const Eigen::Index num_col = mat.cols();
+        const Eigen::Index chunk_size = std::max<Eigen::Index>(256, rowChunkSize(num_col));
+        const int64_t num_chunks = (num_row + chunk_size - 1) / chunk_size;
+
+        const Eigen::Matrix<Scalar, 1, -1> shiftRow = shift.transpose();
+        const Eigen::Matrix<Scalar, -1, 1> invNormFacs = normFacs.cwiseInverse();
+
+        Matrix scatter = Matrix::Zero(num_col, num_col);
+
+        ChunkProgress chunkProgress(progress, PHASE::DECOMPOSE, num_chunks);
+
+#pragma omp parallel num_threads(scatterThreads(num_col, sizeof(Scalar)))
         {
-            num_comp = num_dims;
-            pca_out = data_in;
-            std::cout << "pca: num_dims == 1, no transformation is performed" << std::endl;;
-            return false;
+            Matrix localScatter = Matrix::Zero(num_col, num_col);
+            Matrix chunk;
+
+#pragma omp for
+            for (int64_t chunkID = 0; chunkID < num_chunks; chunkID++)
+            {
+                if (isCancelled(cancel))
+                    continue;
+
+                const Eigen::Index begin = chunkID * chunk_size;
+                const Eigen::Index len = std::min(chunk_size, num_row - begin);
+
+                chunk.noalias() = (mat.middleRows(begin, len).template cast<Scalar>().rowwise() - shiftRow) * invNormFacs.asDiagonal();
+                localScatter.template selfadjointView<Eigen::Lower>().rankUpdate(chunk.transpose());
+
+                chunkProgress.chunkDone();
+            }
+
+#pragma omp critical
+            scatter.template triangularView<Eigen::Lower>() += localScatter;
         }
 
-        // convert std vector to Eigen MatrixXf
-        Eigen::MatrixXf data = convertStdVectorToEigenMatrix(data_in, num_dims);
+        throwIfCancelled(cancel);
+        chunkProgress.finish();
 
-        // check number of component against number of rows and columns
-        const size_t num_row = data.rows();
-        const size_t num_col = data.cols();
-        size_t _num_comp = num_comp;
-        checkNumComponents(num_row, num_col, _num_comp);
-
-        assert(num_row * num_col == data_in.size());
-        assert(num_col == num_dims);
-
-        // choose which data normalization to use
-        auto norm_data = [&](const Eigen::MatrixXf& dat) {
-            if (norm == DATA_NORM::MINMAX)
-                return minMaxNormalization(dat);
-            else if (norm == DATA_NORM::MEAN)
-                return meanNormalization(dat);
-            else // norm == DATA_NORM::NONE
-                return dat;
-        };
-
-        // choose which pcaSVD algorithm to use 
-        auto pca_alg = [&](const Eigen::MatrixXf& dat) {
-            if (algorithm == PCA_ALG::SVD)
-                return pcaSVD(dat, _num_comp);
-            else // algorithm == PCA_ALG::COV
-                return pcaCovMat(dat, _num_comp);
-        };
-
-        // prep data: normalization
-        Eigen::MatrixXf data_normed = norm_data(data);
-
-        // Center the values of each variable in the dataset on 0 by subtracting the mean of the variable's observed values from each of those values
-        data_normed = colwiseZeroMean(data_normed);
-
-        // compute pcaSVD, get first num_comp components
-        Eigen::MatrixXf principal_components;
-        try {
-            principal_components = pca_alg(data_normed);
+        return scatter;
+    }
+
+    // Scatter matrix of data that already has column-wise zero empirical mean
+    template<typename Derived>
+    inline Eigen::Matrix<typename Derived::Scalar, -1, -1> scatterMatrix(const Eigen::MatrixBase<Derived>& mat, const CancellationToken* cancel = nullptr)
+    {
+        using Vector = Eigen::Matrix<typename Derived::Scalar, -1, 1>;
+        return scatterMatrix<typename Derived::Scalar>(mat, Vector::Zero(mat.cols()), Vector::Ones(mat.cols()), cancel);
+    }
+
+    // Principal components from the lower triangle of a scatter or covariance matrix
+    // Optionally refines the eigenvectors with params.refinementSteps subspace iteration steps and returns the eigenvalues
+    template<typename Scalar>
+    inline Eigen::Matrix<Scalar, -1, -1> pcaScatterMat(const Eigen::Matrix<Scalar, -1, -1>& scatter, const size_t num_comp, const SolverParams& params = {}, Eigen::Matrix<Scalar, -1, 1>* eigenvalues_out = nullptr)
+    {
+        Eigen::Matrix<Scalar, -1, -1> eigenvectors;
+        Eigen::Matrix<Scalar, -1, 1> eigenvalues;
+        largestEigenpairs(scatter, num_comp, eigenvectors, eigenvalues, params);
+        refineEigenpairs(scatter, eigenvectors, eigenvalues, params.refinementSteps, params.cancel);
+
+        if (eigenvalues_out)
+            *eigenvalues_out = std::move(eigenvalues);
+
+        return eigenvectors;
+    }
+
+    // data should be have column-wise zero empirical mean 
+    template<typename Derived>
+    inline Eigen::Matrix<typename Derived::Scalar, -1, -1> pcaCovMat(const Eigen::MatrixBase<Derived>& data, const size_t num_comp, const SolverParams& params = {})
+    {
+        // covariance matrix, up to the factor 1 / (num_row - 1) which does not change the eigenvectors
+        return pcaScatterMat(scatterMatrix(data, params.cancel), num_comp, params);
+    }
+
+    // Dual formulation of pcaCovMat for data with fewer rows than columns
+    // Eigendecomposition of the num_row x num_row Gram matrix data * data^T = U S^2 U^T instead of the num_col x num_col covariance matrix
+    // Returns the principal components V = data^T U S^-1 and sets the projection data_transformed = data * V = U S
+    // Optionally returns the eigenvalues S^2, which equal those of the covariance formulation
+    // data should be have column-wise zero empirical mean 
+    template<typename Derived>
+    inline Eigen::Matrix<typename Derived::Scalar, -1, -1> pcaGramMat(const Eigen::MatrixBase<Derived>& data, const size_t num_comp, Eigen::Matrix<typename Derived::Scalar, -1, -1>& data_transformed, const SolverParams& params = {}, Eigen::Matrix<typename Derived::Scalar, -1, 1>* eigenvalues_out = nullptr)
+    {
+        using Scalar = typename Derived::Scalar;
+        using Matrix = Eigen::Matrix<Scalar, -1, -1>;
+        using Vector = Eigen::Matrix<Scalar, -1, 1>;
+
+        // Gram matrix, only the lower triangle is computed
+        Matrix gramMat = Matrix::Zero(data.rows(), data.rows());
+        gramMat.template selfadjointView<Eigen::Lower>().rankUpdate(data);
+        throwIfCancelled(params.cancel);
+
+        Matrix eigenvectors;
+        Vector eigenvalues;
+        largestEigenpairs(gramMat, num_comp, eigenvectors, eigenvalues, params);
+
+        // singular values of data, numerically zero singular values yield zero components
+        const Vector singularValues = eigenvalues.cwiseMax(Scalar(0)).cwiseSqrt();
+        const Scalar eps = std::numeric_limits<Scalar>::epsilon() * std::max(singularValues[0], Scalar(1)) * static_cast<Scalar>(data.rows());
+        const Vector invSingularValues = singularValues.unaryExpr([eps](Scalar s) { return s > eps ? Scalar(1) / s : Scalar(0); });
+
+        data_transformed = eigenvectors * singularValues.asDiagonal();
+
+        if (eigenvalues_out)
+            *eigenvalues_out = singularValues.cwiseAbs2();
+
+        return (data.transpose() * eigenvectors) * invSingularValues.asDiagonal();
+    }
+
+    // Randomized range finder followed by an SVD of the small projected matrix
+    // Halko, Martinsson, Tropp (2011): Finding structure with randomness, Algorithms 4.4 and 5.1
+    // data should be have column-wise zero empirical mean 
+    // Optionally returns the approximations of the num_comp largest singular values of data
+    // With params.varianceFraction, num_comp is an upper bound: restarts with twice the components until the fraction of the variance is explained
+    template<typename Derived>
+    inline Eigen::Matrix<typename Derived::Scalar, -1, -1> pcaRandomizedSVD(const Eigen::MatrixBase<Derived>& data, const size_t num_comp, const SolverParams& params = {}, Eigen::Matrix<typename Derived::Scalar, -1, 1>* singular_values = nullptr)
+    {
+        using Matrix = Eigen::Matrix<typename Derived::Scalar, -1, -1>;
+        using Vector = Eigen::Matrix<typename Derived::Scalar, -1, 1>;
+
+        if (useVarianceFraction(params))
+        {
+            const double totalVariance = static_cast<double>(data.squaredNorm());
+            const double target = static_cast<double>(params.varianceFraction) * totalVariance;
+
+            SolverParams fixedParams = params;
+            fixedParams.varianceFraction = 0.0f;
+
+            size_t num_round = std::clamp<size_t>(params.initialComponents, 1, num_comp);
+            while (true)
+            {
+                Vector sv;
+                Matrix components = pcaRandomizedSVD(data, num_round, fixedParams, &sv);
+                const Vector variances = sv.cwiseAbs2();
+
+                if (variances.template cast<double>().sum() >= target || num_round == num_comp)
+                {
+                    const size_t num_keep = numComponentsForVariance(variances, totalVariance, params.varianceFraction);
+                    if (singular_values)
+                        *singular_values = sv.head(num_keep);
+                    return components.leftCols(num_keep);
+                }
+
+                num_round = std::min(2 * num_round, num_comp);
+            }
         }
-        catch (const std::runtime_error& ex) {
-            std::cout << "PCA could not be computed: " << ex.what() << std::endl;
-            pca_out = std::vector(data.rows() * num_comp, 0.0f);
-            return false;
+
+        const int64_t num_row = data.rows();
+        const int64_t num_col = data.cols();
+
+        // number of samples of the range of data
+        const int64_t num_samples = std::min<int64_t>(num_comp + params.oversampling, std::min(num_row, num_col));
+
+        // gaussian test matrix, drawn in float such that all scalar types see the same samples for a seed
+        std::mt19937 gen(params.seed);
+        std::normal_distribution<float> dist(0.0f, 1.0f);
+        Matrix omega(num_col, num_samples);
+        for (int64_t col = 0; col < num_samples; col++)
+            for (int64_t row = 0; row < num_col; row++)
+                omega(row, col) = static_cast<typename Derived::Scalar>(dist(gen));
+
+        // sample the range of data, re-orthonormalize after each application of data to avoid loss of precision
+        Matrix Q = orthonormalBasis(data * omega);
+        for (size_t iter = 0; iter < params.powerIterations; iter++)
+        {
+            throwIfCancelled(params.cancel);
+            reportProgress(params.progress, PHASE::DECOMPOSE, static_cast<float>(iter + 1) / static_cast<float>(params.powerIterations + 2));
+            Q = orthonormalBasis(data.transpose() * Q);
+            Q = orthonormalBasis(data * Q);
         }
 
-        // project data, compute pca components and
-        Eigen::MatrixXf data_transformed = pcaTransform(data_normed, principal_components);
+        // project data onto the range basis, num_samples x num_col
+        throwIfCancelled(params.cancel);
+        Matrix B = Q.transpose() * data;
 
-        // enforce same orientation (flip axis) for all algorithms 
-        if (stdOrientation)
-            data_transformed = math::standardOrientation(data_transformed);
+        Eigen::BDCSVD<Matrix, Eigen::ComputeThinV> svd(B);
 
-        // convert to std vector with [p0d0, p0d1, ..., p1d0, p1d1, ..., pNd0, pNd1, ..., pNdM]
-        pca_out = convertEigenMatrixToStdVector(data_transformed);
+        if (svd.info() != Eigen::Success)
+            throw (std::runtime_error("pcaRandomizedSVD failed. Eigen::ComputationInfo " + std::to_string(static_cast<int32_t>(svd.info()))));
 
-        return true;
+        if (singular_values)
+            *singular_values = svd.singularValues().head(num_comp);
+
+        return svd.matrixV()(Eigen::placeholders::all, Eigen::seq(0, num_comp - 1));
+    }
 
+    template<typename Derived, typename DerivedPC>
+    inline Eigen::Matrix<typename Derived::Scalar, -1, -1> pcaTransform(const Eigen::MatrixBase<Derived>& data, const Eigen::MatrixBase<DerivedPC>& principal_components)
+    {
+        return data * principal_components;
     }
 
+    // Projects (data - shift) / normFacs onto the principal components into out, chunk by chunk in parallel
+    // The normalized data is never materialized, each thread only normalizes and centers one chunk at a time
+    // data and out may have either storage order
+    template<typename Derived, typename DerivedOut>
+    inline void pcaTransform(const Eigen::MatrixBase<Derived>& data, const Eigen::Matrix<typename Derived::Scalar, -1, 1>& shift, const Eigen::Matrix<typename Derived::Scalar, -1, 1>& normFacs, const Eigen::Matrix<typename Derived::Scalar, -1, -1>& principal_components, Eigen::MatrixBase<DerivedOut>& out, const CancellationToken* cancel = nullptr, const ProgressCallback& progress = {})
+    {
+        using Scalar = typename Derived::Scalar;
+        using Matrix = Eigen::Matrix<Scalar, -1, -1>;
+
+        const Eigen::Index num_row = data.rows();
+        const Eigen::Index chunk_size = rowChunkSize(data.cols());
+        const int64_t num_chunks = (num_row + chunk_size - 1) / chunk_size;
+
+        assert(out.rows() == num_row && out.cols() == principal_components.cols());
+
+        const Eigen::Matrix<Scalar, 1, -1> shiftRow = shift.transpose();
+        const Matrix scaledComponents = normFacs.cwiseInverse().asDiagonal() * principal_components;
+
+        ChunkProgress chunkProgress(progress, PHASE::PROJECT, num_chunks);
+
+#pragma omp parallel
+        {
+            Matrix chunk;
+
+#pragma omp for
+            for (int64_t chunkID = 0; chunkID < num_chunks; chunkID++)
+            {
+                if (isCancelled(cancel))
+                    continue;
+
+                const Eigen::Index begin = chunkID * chunk_size;
+                const Eigen::Index len = std::min(chunk_size, num_row - begin);
+
+                chunk.noalias() = data.middleRows(begin, len).rowwise() - shiftRow;
+                out.middleRows(begin, len).noalias() = chunk * scaledComponents;
+
+                chunkProgress.chunkDone();
+            }
+        }
+
+        throwIfCancelled(cancel);
+        chunkProgress.finish();
+    }
+
+    template<typename Derived>
+    inline RowMajorMatrix<typename Derived::Scalar> pcaTransform(const Eigen::MatrixBase<Derived>& data, const Eigen::Matrix<typename Derived::Scalar, -1, 1>& shift, const Eigen::Matrix<typename Derived::Scalar, -1, 1>& normFacs, const Eigen::Matrix<typename Derived::Scalar, -1, -1>& principal_components)
+    {
+        RowMajorMatrix<typename Derived::Scalar> data_transformed(data.rows(), principal_components.cols());
+        pcaTransform(data, shift, normFacs, principal_components, data_transformed);
+        return data_transformed;
+    }
+
+    // Rough upper bound of the working memory in bytes of PcaModel::fit and transform for num_row x num_col data, excluding the input and output
+    // Mirrors the dispatch in PcaModel::fit, e.g. to schedule several pca without exceeding the available memory
+    template<typename Scalar = float>
+    inline size_t estimateWorkingBytes(const size_t num_row, const size_t num_col, const size_t num_comp, const PCA_ALG algorithm, const SolverParams& params = {})
+    {
+        const size_t num_min = std::min(num_row, num_col);
+        const size_t num_k = std::min(num_comp, num_min);
+        const size_t num_block = std::min(num_k + params.oversampling, num_min);
+
+        // covariance matrix: per-thread scatter accumulators, the merged scatter matrix and its eigendecomposition
+        if (algorithm == PCA_ALG::COV && num_row >= num_col)
+        {
+            const size_t bytes = (params.precision == PRECISION::MIXED && !std::is_same_v<Scalar, double>) ? sizeof(double) : sizeof(Scalar);
+            const size_t scatterBytes = num_col * num_col * bytes;
+            const size_t threads = static_cast<size_t>(scatterThreads(static_cast<Eigen::Index>(num_col), bytes));
+            const bool partial = usePartialEigensolver(num_col, num_k, params) || useVarianceFraction(params);
+            const size_t eigenBytes = partial ? 4 * num_col * num_block * bytes : 2 * scatterBytes;
+            return (threads + 1) * scatterBytes + eigenBytes;
+        }
+
+        // the other algorithms work on a normalized and centered copy of the data
+        size_t bytes = num_row * num_col;
+        if (algorithm == PCA_ALG::COV)             // Gram matrix and its eigenvectors
+            bytes += 2 * num_row * num_row + num_row * num_k + num_col * num_k;
+        else if (algorithm == PCA_ALG::SVD)        // copy of the SVD, its right singular vectors and bidiagonalization
+            bytes += num_row * num_col + num_col * num_min + num_min * num_min;
+        else                                        // range basis and projected matrix
+            bytes += 2 * num_row * num_block + 2 * num_block * num_col;
+
+        return bytes * sizeof(Scalar);
+    }
+
+    /// //////// ///
+    /// SAMPLING ///
+    /// //////// ///
+
+    // sample_size distinct rows of num_rows, drawn uniformly at random and returned in increasing order
+    // All rows if sample_size >= num_rows. Floyd's algorithm on a bitmap, so only sample_size random numbers are drawn
+    inline std::vector<Eigen::Index> uniformSample(const size_t num_rows, const size_t sample_size, const uint32_t seed = 0)
+    {
+        std::vector<Eigen::Index> sample;
+
+        if (sample_size >= num_rows)
+        {
+            sample.resize(num_rows);
+            std::iota(sample.begin(), sample.end(), Eigen::Index(0));
+            return sample;
+        }
+
+        std::mt19937_64 gen(seed);
+        std::vector<bool> selected(num_rows, false);
+        for (size_t candidate = num_rows - sample_size; candidate < num_rows; candidate++)
+        {
+            const size_t row = std::uniform_int_distribution<size_t>(0, candidate)(gen);
+            selected[selected[row] ? candidate : row] = true;
+        }
+
+        sample.reserve(sample_size);
+        for (size_t row = 0; row < num_rows; row++)
+            if (selected[row])
+                sample.push_back(static_cast<Eigen::Index>(row));
+
+        return sample;
+    }
+
+    // About sample_size rows, drawn such that each stratum is represented in proportion to its size, returned in increasing order
+    // labels holds the stratum of each row, e.g. its cluster. Each non-empty stratum gets at least one row if sample_size allows
+    // Rows are drawn uniformly within each stratum
+    inline std::vector<Eigen::Index> stratifiedSample(std::span<const uint32_t> labels, const size_t sample_size, const uint32_t seed = 0)
+    {
+        const size_t num_rows = labels.size();
+
+        if (sample_size >= num_rows)
+            return uniformSample(num_rows, num_rows);
+
+        const uint32_t num_strata = labels.empty() ? 0 : *std::max_element(labels.begin(), labels.end()) + 1;
+
+        std::vector<size_t> stratumSizes(num_strata, 0);
+        for (const uint32_t label : labels)
+            stratumSizes[label]++;
+
+        // proportional allocation, rounded down, the remaining rows go to the strata with the largest remainders
+        std::vector<size_t> allocation(num_strata, 0);
+        std::vector<double> remainders(num_strata, 0.0);
+        size_t num_allocated = 0;
+        for (uint32_t stratum = 0; stratum < num_strata; stratum++)
+        {
+            const double share = static_cast<double>(sample_size) * static_cast<double>(stratumSizes[stratum]) / static_cast<double>(num_rows);
+            allocation[stratum] = static_cast<size_t>(share);
+            remainders[stratum] = share - static_cast<double>(allocation[stratum]);
+
+            // small strata are represented by at least one row
+            if (allocation[stratum] == 0 && stratumSizes[stratum] > 0)
+            {
+                allocation[stratum] = 1;
+                remainders[stratum] = 0.0;
+            }
+
+            num_allocated += allocation[stratum];
+        }
+
+        for (const size_t stratum : argsort(remainders, std::greater{}))
+        {
+            if (num_allocated >= sample_size)
+                break;
+            if (allocation[stratum] < stratumSizes[stratum])
+            {
+                allocation[stratum]++;
+                num_allocated++;
+            }
+        }
+
+        // ranks of the drawn rows within each stratum, mapped to rows in one pass over the labels
+        std::vector<std::vector<Eigen::Index>> ranks(num_strata);
+        for (uint32_t stratum = 0; stratum < num_strata; stratum++)
+            ranks[stratum] = uniformSample(stratumSizes[stratum], allocation[stratum], seed + stratum);
+
+        std::vector<size_t> rankPos(num_strata, 0);
+        std::vector<Eigen::Index> stratumRow(num_strata, 0);
+        std::vector<Eigen::Index> sample;
+        sample.reserve(num_allocated);
+        for (size_t row = 0; row < num_rows; row++)
+        {
+            const uint32_t stratum = labels[row];
+            if (rankPos[stratum] < ranks[stratum].size() && ranks[stratum][rankPos[stratum]] == stratumRow[stratum])
+            {
+                sample.push_back(static_cast<Eigen::Index>(row));
+                rankPos[stratum]++;
+            }
+            stratumRow[stratum]++;
+        }
+
+        return sample;
+    }
+
+    // Strategy that is actually used to fit num_rows rows with a sample of sample_size rows
+    // A sample that is not smaller than the data is the data, without strata the sample is drawn uniformly
+    inline FIT_SAMPLE resolveFitSample(const FIT_SAMPLE strategy, const size_t num_rows, const size_t sample_size, const bool hasStrata)
+    {
+        if (strategy == FIT_SAMPLE::ALL_POINTS || sample_size >= num_rows)
+            return FIT_SAMPLE::ALL_POINTS;
+
+        if (strategy == FIT_SAMPLE::STRATIFIED && !hasStrata)
+            return FIT_SAMPLE::UNIFORM;
+
+        return strategy;
+    }
+
+    // Rows of the fit sample in increasing order, empty for FIT_SAMPLE::ALL_POINTS, see resolveFitSample
+    // labels holds the stratum of each of the num_rows rows and is only used by FIT_SAMPLE::STRATIFIED
+    inline std::vector<Eigen::Index> fitSampleRows(const FIT_SAMPLE strategy, const size_t num_rows, const size_t sample_size, std::span<const uint32_t> labels = {}, const uint32_t seed = 0)
+    {
+        switch (resolveFitSample(strategy, num_rows, sample_size, labels.size() == num_rows))
+        {
+        case FIT_SAMPLE::UNIFORM:       return uniformSample(num_rows, sample_size, seed);
+        case FIT_SAMPLE::STRATIFIED:    return stratifiedSample(labels, sample_size, seed);
+        default:                        return {};
+        }
+    }
+
+    // Copy of the given rows of data, row-major such that each row is copied in one piece
+    template<typename Derived>
+    inline RowMajorMatrix<typename Derived::Scalar> sampleRows(const Eigen::MatrixBase<Derived>& data, const std::vector<Eigen::Index>& rows)
+    {
+        RowMajorMatrix<typename Derived::Scalar> sample(static_cast<Eigen::Index>(rows.size()), data.cols());
+
+#pragma omp parallel for
+        for (int64_t row = 0; row < static_cast<int64_t>(rows.size()); row++)
+            sample.row(row) = data.row(rows[row]);
+
+        return sample;
+    }
+
+    // Largest principal angle in radians between the column spaces of two matrices with orthonormal columns
+    // The cosines of the principal angles are the singular values of A^T B, Bjoerck & Golub (1973)
+    template<typename DerivedA, typename DerivedB>
+    inline double subspaceAngle(const Eigen::MatrixBase<DerivedA>& A, const Eigen::MatrixBase<DerivedB>& B)
+    {
+        const Eigen::MatrixXd overlap = A.template cast<double>().transpose() * B.template cast<double>();
+        const Eigen::JacobiSVD<Eigen::MatrixXd> svd(overlap);
+        const double minCosine = svd.singularValues().size() > 0 ? svd.singularValues().minCoeff() : 0.0;
+        return std::acos(std::clamp(minCosine, 0.0, 1.0));
+    }
+
+    // Rows of next that differ bitwise from the row at the same position in prev or that are appended, in increasing order
+    // Both are row-major with num_dims columns, e.g. two extractions of live data of which only the changed rows are updated
+    template<typename Scalar>
+    inline std::vector<Eigen::Index> changedRows(std::type_identity_t<std::span<const Scalar>> prev, std::type_identity_t<std::span<const Scalar>> next, const size_t num_dims)
+    {
+        const size_t num_prev = prev.size() / num_dims;
+        const size_t num_next = next.size() / num_dims;
+        const size_t num_common = std::min(num_prev, num_next);
+
+        std::vector<std::uint8_t> changed(num_common);
+
+#pragma omp parallel for
+        for (int64_t row = 0; row < static_cast<int64_t>(num_common); row++)
+            changed[row] = std::memcmp(prev.data() + row * num_dims, next.data() + row * num_dims, num_dims * sizeof(Scalar)) != 0;
+
+        std::vector<Eigen::Index> rows;
+        for (size_t row = 0; row < num_common; row++)
+            if (changed[row])
+                rows.push_back(static_cast<Eigen::Index>(row));
+
+        for (size_t row = num_common; row < num_next; row++)
+            rows.push_back(static_cast<Eigen::Index>(row));
+
+        return rows;
+    }
+
+    /// ///// ///
+    /// MODEL ///
+    /// ///// ///
+
+    // Fitted pca: normalization factors, mean, principal components and their eigenvalues
+    // fit() decomposes the data once, transform() then projects any data with the same dimensions onto the fitted basis
+    // in one fused, parallel normalize-center-project pass over chunks of rows, e.g. streaming batches
+    // Call like:
+    /*
+    math::PcaModel<float> model;
+    model.fit(math::mapRowMajor(data, num_dims), num_comp, math::PCA_ALG::COV, math::DATA_NORM::MINMAX);
+    math::RowMajorMatrixXf batch_out = model.transform(math::mapRowMajor(batch, num_dims));
+    */
+    template<typename Scalar = float>
+    class PcaModel
+    {
+    public:
+        using Matrix = Eigen::Matrix<Scalar, -1, -1>;
+        using Vector = Eigen::Matrix<Scalar, -1, 1>;
+
+        PcaModel() = default;
+
+        // Model of a decomposition that was computed elsewhere, e.g. by CovarianceAccumulator::finalize
+        PcaModel(const DATA_NORM norm, const size_t num_rows, Vector mean, Vector normFactors, Matrix components, Vector eigenvalues, const Scalar totalVariance) :
+            _norm(norm),
+            _num_rows(num_rows),
+            _mean(std::move(mean)),
+            _normFactors(std::move(normFactors)),
+            _components(std::move(components)),
+            _eigenvalues(std::move(eigenvalues)),
+            _totalVariance(totalVariance)
+        {
+        }
+
+        // Fit to data of either storage order, num_comp must be valid, see checkNumComponents
+        // With solverParams.varianceFraction, num_comp is an upper bound and numComponents() is the number of selected components
+        // Throws std::runtime_error if the decomposition fails and Cancelled if solverParams.cancel is cancelled
+        template<typename Derived>
+        void fit(const Eigen::MatrixBase<Derived>& data, const size_t num_comp, const PCA_ALG algorithm = PCA_ALG::SVD, const DATA_NORM norm = DATA_NORM::MINMAX, const SolverParams& solverParams = {})
+        {
+            static_assert(std::is_same_v<Scalar, typename Derived::Scalar>, "PcaModel: data must have the scalar type of the model");
+
+            const CancellationToken* cancel = solverParams.cancel;
+            const ProgressCallback& progress = solverParams.progress;
+
+            const Eigen::Index num_row = data.rows();
+            const Eigen::Index num_col = data.cols();
+
+            // wide data: the Gram matrix is smaller than the covariance matrix
+            const bool useGramMat = (algorithm == PCA_ALG::COV) && (num_row < num_col);
+
+            // the covariance matrix normalizes and centers the input chunk-wise, no working matrix is needed
+            const bool useScatterMat = (algorithm == PCA_ALG::COV) && !useGramMat;
+
+            // prep data: statistics for normalization and centering in one pass over the input
+            // Center the values of each variable in the dataset on 0 by subtracting the mean of the variable's observed values from each of those values
+            const ColumnStatistics<Scalar> stats = columnStatistics(data, cancel, progress);
+            Vector mean = stats.mean.template cast<Scalar>();
+            Vector normFacs = normalizationFactors(stats.minVals, stats.maxVals, norm);
+
+            // the other algorithms work on the column-major, normalized and centered working matrix
+            Matrix data_normed;
+            if (!useScatterMat)
+                shiftAndScale(data, mean, normFacs, data_normed, cancel, progress);
+            else // centering is fused into the scatter matrix
+                reportProgress(progress, PHASE::CENTER, 1.0f);
+
+            // compute the first num_comp components and the eigenvalues of the scatter matrix
+            reportProgress(progress, PHASE::DECOMPOSE, 0.0f);
+            // the total variance is the trace of the scatter matrix, the sum of all eigenvalues, even if only the first few are computed
+            Matrix components;
+            Vector eigenvalues;
+            Scalar totalVariance = 0;
+            Matrix fittedProjection;
+            if (useGramMat)
+            {
+                // the Gram matrix yields the projection of the fitted data as U S, keep it instead of projecting again
+                components = pcaGramMat(data_normed, num_comp, fittedProjection, solverParams, &eigenvalues);
+                totalVariance = data_normed.squaredNorm();
+            }
+            else if (useScatterMat && solverParams.precision == PRECISION::MIXED && !std::is_same_v<Scalar, double>)
+            {
+                const Eigen::MatrixXd scatter = scatterMatrix(data, stats.mean, Eigen::VectorXd(normFacs.template cast<double>()), cancel, progress);
+                Eigen::VectorXd eigenvaluesD;
+                components = pcaScatterMat(scatter, num_comp, solverParams, &eigenvaluesD).template cast<Scalar>();
+                eigenvalues = eigenvaluesD.template cast<Scalar>();
+                totalVariance = static_cast<Scalar>(scatter.trace());
+            }
+            else if (useScatterMat)
+            {
+                const Matrix scatter = scatterMatrix(data, mean, normFacs, cancel, progress);
+                components = pcaScatterMat(scatter, num_comp, solverParams, &eigenvalues);
+                totalVariance = scatter.trace();
+            }
+            else
+            {
+                totalVariance = data_normed.squaredNorm();
+                if (algorithm == PCA_ALG::SVD)
+                    components = pcaSVD(data_normed, num_comp, &eigenvalues);
+                else // algorithm == PCA_ALG::RANDOMIZED
+                    components = pcaRandomizedSVD(data_normed, num_comp, solverParams, &eigenvalues);
+                eigenvalues = eigenvalues.cwiseAbs2();
+            }
+
+            // the SVD computes all singular values anyway, the other solvers stopped once the fraction was explained
+            if (useVarianceFraction(solverParams))
+            {
+                const size_t num_keep = numComponentsForVariance(eigenvalues, static_cast<double>(totalVariance), solverParams.varianceFraction);
+                components = components.leftCols(num_keep).eval();
+                eigenvalues = eigenvalues.head(num_keep).eval();
+                if (fittedProjection.size() > 0)
+                    fittedProjection = fittedProjection.leftCols(num_keep).eval();
+            }
+
+            throwIfCancelled(cancel);
+            reportProgress(progress, PHASE::DECOMPOSE, 1.0f);
+
+            _norm = norm;
+            _num_rows = static_cast<size_t>(num_row);
+            _mean = std::move(mean);
+            _normFactors = std::move(normFacs);
+            _components = std::move(components);
+            _fittedProjection = std::move(fittedProjection);
+            _eigenvalues = eigenvalues / static_cast<Scalar>(std::max<Eigen::Index>(num_row - 1, 1));
+            _totalVariance = totalVariance / static_cast<Scalar>(std::max<Eigen::Index>(num_row - 1, 1));
+        }
+
+        // Normalize, center and project data of either storage order into out, num_rows x numComponents() of either storage order
+        template<typename Derived, typename DerivedOut>
+        void transform(const Eigen::MatrixBase<Derived>& data, Eigen::MatrixBase<DerivedOut>& out, const CancellationToken* cancel = nullptr, const ProgressCallback& progress = {}) const
+        {
+            pcaTransform(data, _mean, _normFactors, _components, out, cancel, progress);
+        }
+
+        template<typename Derived>
+        RowMajorMatrix<Scalar> transform(const Eigen::MatrixBase<Derived>& data) const
+        {
+            return pcaTransform(data, _mean, _normFactors, _components);
+        }
+
+        // Model with only the first num_comp components, e.g. of a fit that computed more components than currently needed
+        PcaModel truncated(const size_t num_comp) const
+        {
+            PcaModel model = *this;
+            const Eigen::Index num_keep = std::min<Eigen::Index>(num_comp, _components.cols());
+            model._components = _components.leftCols(num_keep);
+            model._eigenvalues = _eigenvalues.head(num_keep);
+            if (_fittedProjection.size() > 0)
+                model._fittedProjection = _fittedProjection.leftCols(num_keep);
+            return model;
+        }
+
+        // Flip the components such that the max abs value of each dimension of transformed is positive, see standardOrientation
+        // transformed is the projection of the fitted data, it is flipped in place, like the kept fittedProjection()
+        template<typename DerivedOut>
+        void orient(Eigen::MatrixBase<DerivedOut>& transformed)
+        {
+            Eigen::Index rowID;
+            for (Eigen::Index colID = 0; colID < transformed.cols(); colID++)
+            {
+                transformed.col(colID).cwiseAbs().maxCoeff(&rowID);
+                if (transformed(rowID, colID) >= 0)
+                    continue;
+
+                transformed.col(colID) *= typename DerivedOut::Scalar(-1);
+                _components.col(colID) *= Scalar(-1);
+                if (_fittedProjection.size() > 0)
+                    _fittedProjection.col(colID) *= Scalar(-1);
+            }
+        }
+
+        size_t numRows() const { return _num_rows; }
+        size_t numDims() const { return _mean.size(); }
+        size_t numComponents() const { return _components.cols(); }
+        DATA_NORM norm() const { return _norm; }
+        const Vector& mean() const { return _mean; }
+        const Vector& normFactors() const { return _normFactors; }
+        const Matrix& components() const { return _components; }
+        const Vector& eigenvalues() const { return _eigenvalues; }
+        Scalar totalVariance() const { return _totalVariance; }
+
+        // Projection of the fitted data onto the components, only kept by fits that get it for free (the Gram matrix of wide data), empty otherwise
+        const Matrix& fittedProjection() const { return _fittedProjection; }
+
+        // Fraction of the total variance along each component
+        Vector explainedVarianceRatio() const
+        {
+            if (_totalVariance <= Scalar(0))
+                return Vector::Zero(_eigenvalues.size());
+            return _eigenvalues / _totalVariance;
+        }
+
+        // Fraction of the total variance along the first 1, 2, ... components
+        Vector cumulativeExplainedVarianceRatio() const
+        {
+            Vector cumulative = explainedVarianceRatio();
+            std::partial_sum(cumulative.begin(), cumulative.end(), cumulative.begin());
+            return cumulative;
+        }
+
+    private:
+        DATA_NORM   _norm = DATA_NORM::NONE;
+        size_t      _num_rows = 0;          /** Number of fitted rows */
+        Vector      _mean;                  /** Column means of the fitted data */
+        Vector      _normFactors;           /** Column scaling, see normalizationFactors */
+        Matrix      _components;            /** Principal components, num_dims x num_comp */
+        Matrix      _fittedProjection;      /** Projection of the fitted data, num_rows x num_comp, see fittedProjection */
+        Vector      _eigenvalues;           /** Variance of the normalized fitted data along each component, in decreasing order */
+        Scalar      _totalVariance = 0;     /** Variance of the normalized fitted data, sum of all eigenvalues */
+    };
+
+    /// //////////////////// ///
+    /// CHUNKED ACCUMULATION ///
+    /// //////////////////// ///
+
+    // One-pass accumulation of column statistics (mean, min, max) and the scatter matrix from chunks of rows
+    // Chunks are merged with the pairwise update by Chan, Golub, LeVeque (1979), statistics are kept in double precision
+    // Peak memory is O(num_dims^2 + chunk), the full data never needs to be in memory at once
+    // Call like:
+    /*
+    math::CovarianceAccumulator acc(num_dims);
+    for (const auto& chunk : chunks)                                    // row-major [p0d0, p0d1, ..., p1d0, ...]
+        acc.addChunk(chunk.data(), chunk.size() / num_dims);
+    acc.finalize(num_comp, math::DATA_NORM::MINMAX);
+    for (const auto& chunk : chunks)                                    // second pass to project the data
+        acc.transformChunk(chunk.data(), chunk.size() / num_dims, out.data() + offset);
+    */
+    class CovarianceAccumulator
+    {
+    public:
+        explicit CovarianceAccumulator(const size_t num_dims) :
+            _num_dims(num_dims),
+            _mean(Eigen::VectorXd::Zero(num_dims)),
+            _minVals(Eigen::VectorXf::Constant(num_dims, std::numeric_limits<float>::max())),
+            _maxVals(Eigen::VectorXf::Constant(num_dims, std::numeric_limits<float>::lowest())),
+            _scatter(Eigen::MatrixXd::Zero(num_dims, num_dims))
+        {
+        }
+
+        // Add num_rows rows of row-major data, large chunks are accumulated in parallel with the blocked scatter kernel
+        // Throws Cancelled if cancel is cancelled, the accumulator is unchanged then
+        void addChunk(const float* data, const size_t num_rows, const CancellationToken* cancel = nullptr, const ProgressCallback& progress = {})
+        {
+            if (num_rows == 0)
+                return;
+
+            const Eigen::Map<const Eigen::Matrix<float, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>> chunk(data, num_rows, _num_dims);
+
+            const ColumnStatistics<float> stats = columnStatistics(chunk, cancel, progress);
+
+            CovarianceAccumulator chunkStats(_num_dims);
+            chunkStats._num_rows = num_rows;
+            chunkStats._minVals = stats.minVals;
+            chunkStats._maxVals = stats.maxVals;
+            chunkStats._mean = stats.mean;
+
+            // scatter of the chunk around its own mean, only the lower triangle is computed
+            chunkStats._scatter = scatterMatrix(chunk, stats.mean, Eigen::VectorXd::Ones(_num_dims).eval(), cancel, progress);
+
+            merge(chunkStats);
+        }
+
+        // Combine the statistics of two accumulators, e.g. from different threads or files
+        void merge(const CovarianceAccumulator& other)
+        {
+            assert(other._num_dims == _num_dims);
+
+            if (other._num_rows == 0)
+                return;
+
+            const double num_a = static_cast<double>(_num_rows);
+            const double num_b = static_cast<double>(other._num_rows);
+            const double num_total = num_a + num_b;
+
+            const Eigen::VectorXd delta = other._mean - _mean;
+
+            _mean += delta * (num_b / num_total);
+            _scatter += other._scatter;
+            _scatter.selfadjointView<Eigen::Lower>().rankUpdate(delta, num_a * num_b / num_total);
+            _minVals = _minVals.cwiseMin(other._minVals);
+            _maxVals = _maxVals.cwiseMax(other._maxVals);
+            _num_rows += other._num_rows;
+        }
+
+        // Remove num_rows rows that were added before, e.g. the old values of rows that changed: merge in reverse, a rank-k downdate of the scatter matrix
+        // Minima and maxima cannot be downdated, returns false if a removed row attained one of them, they may be too wide then
+        // Throws Cancelled if cancel is cancelled, the accumulator is unchanged then
+        bool removeChunk(const float* data, const size_t num_rows, const CancellationToken* cancel = nullptr, const ProgressCallback& progress = {})
+        {
+            if (num_rows == 0)
+                return true;
+
+            assert(num_rows <= _num_rows);
+
+            const Eigen::Map<const Eigen::Matrix<float, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>> chunk(data, num_rows, _num_dims);
+
+            const ColumnStatistics<float> stats = columnStatistics(chunk, cancel, progress);
+            const Eigen::MatrixXd chunkScatter = scatterMatrix(chunk, stats.mean, Eigen::VectorXd::Ones(_num_dims).eval(), cancel, progress);
+
+            if (num_rows == _num_rows)
+            {
+                *this = CovarianceAccumulator(_num_dims);
+                return true;
+            }
+
+            const bool extremaExact = (stats.minVals.array() > _minVals.array()).all() && (stats.maxVals.array() < _maxVals.array()).all();
+
+            const double num_total = static_cast<double>(_num_rows);
+            const double num_b = static_cast<double>(num_rows);
+            const double num_a = num_total - num_b;
+
+            // mean of the remaining rows, the scatter between both means is removed with the weight that merge added it with
+            const Eigen::VectorXd meanRemaining = (num_total * _mean - num_b * stats.mean) / num_a;
+            const Eigen::VectorXd delta = stats.mean - meanRemaining;
+
+            _scatter -= chunkScatter;
+            _scatter.selfadjointView<Eigen::Lower>().rankUpdate(delta, -num_a * num_b / num_total);
+            _mean = meanRemaining;
+            _num_rows -= num_rows;
+
+            return extremaExact;
+        }
+
+        // Statistics of the dimensions dims only, e.g. of a selection of dimensions
+        // The scatter matrix of a subset of dimensions is a principal submatrix, no data is needed
+        template<typename Index>
+        CovarianceAccumulator subset(const std::vector<Index>& dims) const
+        {
+            const Eigen::Index num_sub = static_cast<Eigen::Index>(dims.size());
+
+            CovarianceAccumulator sub(dims.size());
+            sub._num_rows = _num_rows;
+
+            for (Eigen::Index col = 0; col < num_sub; col++)
+            {
+                sub._mean[col] = _mean[dims[col]];
+                sub._minVals[col] = _minVals[dims[col]];
+                sub._maxVals[col] = _maxVals[dims[col]];
+
+                // only the lower triangle of _scatter is valid
+                for (Eigen::Index row = col; row < num_sub; row++)
+                    sub._scatter(row, col) = (dims[row] >= dims[col]) ? _scatter(dims[row], dims[col]) : _scatter(dims[col], dims[row]);
+            }
+
+            return sub;
+        }
+
+        // Compute the first num_comp principal components of the accumulated data after normalization with norm
+        // The eigendecomposition is computed in double for PRECISION::MIXED, in float otherwise
+        bool finalize(size_t& num_comp, const DATA_NORM norm = DATA_NORM::NONE, const SolverParams& params = {})
+        {
+            if (_num_rows < 2)
+            {
+                setError(params, "CovarianceAccumulator: at least two rows are needed");
+                return false;
+            }
+
+            checkNumComponents(_num_rows, _num_dims, num_comp);
+
+            // after centering, both MEAN and MINMAX normalization divide each column by (max - min)
+            _normFactors = normalizationFactors(_minVals, _maxVals, norm);
+
+            _norm = norm;
+
+            const Eigen::VectorXd invNormFactors = _normFactors.cast<double>().cwiseInverse();
+            const Eigen::MatrixXd scatter = _scatter.selfadjointView<Eigen::Lower>();
+            const Eigen::MatrixXd covMat = invNormFactors.asDiagonal() * scatter * invNormFactors.asDiagonal() / static_cast<double>(_num_rows - 1);
+            _totalVariance = static_cast<float>(covMat.trace());
+
+            try {
+                if (params.precision == PRECISION::MIXED)
+                {
+                    Eigen::VectorXd eigenvalues;
+                    _components = pcaScatterMat(covMat, num_comp, params, &eigenvalues).cast<float>();
+                    _eigenvalues = eigenvalues.cast<float>();
+                }
+                else
+                    _components = pcaScatterMat(Eigen::MatrixXf(covMat.cast<float>()), num_comp, params, &_eigenvalues);
+            }
+            catch (const std::runtime_error& ex) {
+                setError(params, ex.what());
+                return false;
+            }
+
+            // fewer components if they are selected by params.varianceFraction
+            num_comp = static_cast<size_t>(_components.cols());
+
+            return true;
+        }
+
+        // Normalize, center and project num_rows rows of row-major data into out, row-major num_rows x num_comp
+        // Requires finalize()
+        void transformChunk(const float* data, const size_t num_rows, float* out) const
+        {
+            assert(_components.rows() == static_cast<Eigen::Index>(_num_dims));
+
+            const Eigen::Map<const Eigen::Matrix<float, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>> chunk(data, num_rows, _num_dims);
+            Eigen::Map<Eigen::Matrix<float, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>> chunk_out(out, num_rows, _components.cols());
+
+            const Eigen::RowVectorXf mean = _mean.cast<float>().transpose();
+            const Eigen::MatrixXf scaledComponents = _normFactors.cwiseInverse().asDiagonal() * _components;
+
+            chunk_out.noalias() = (chunk.rowwise() - mean) * scaledComponents;
+        }
+
+        size_t numRows() const { return _num_rows; }
+        size_t numDims() const { return _num_dims; }
+        const Eigen::VectorXd& mean() const { return _mean; }
+        const Eigen::VectorXf& minValues() const { return _minVals; }
+        const Eigen::VectorXf& maxValues() const { return _maxVals; }
+        Eigen::MatrixXd covariance() const { return Eigen::MatrixXd(_scatter.selfadjointView<Eigen::Lower>()) / static_cast<double>(_num_rows - 1); }
+
+        // Results of finalize()
+        const Eigen::MatrixXf& components() const { return _components; }      // num_dims x num_comp
+        const Eigen::VectorXf& eigenvalues() const { return _eigenvalues; }     // variance along the components
+        const Eigen::VectorXf& normFactors() const { return _normFactors; }
+
+        // Model of the result of finalize(), e.g. to project data of any storage order with PcaModel::transform or pcaInto
+        PcaModel<float> model() const
+        {
+            return { _norm, _num_rows, _mean.cast<float>(), _normFactors, _components, _eigenvalues, _totalVariance };
+        }
+
+    private:
+        size_t          _num_dims;
+        size_t          _num_rows = 0;
+        Eigen::VectorXd _mean;              /** Column means */
+        Eigen::VectorXf _minVals;           /** Column minima */
+        Eigen::VectorXf _maxVals;           /** Column maxima */
+        Eigen::MatrixXd _scatter;           /** Sum of outer products of the centered rows, lower triangle only */
+        DATA_NORM       _norm = DATA_NORM::NONE; /** Normalization of the last finalize() */
+        Eigen::VectorXf _normFactors;       /** Column scaling applied before the decomposition */
+        Eigen::MatrixXf _components;        /** Principal components */
+        Eigen::VectorXf _eigenvalues;       /** Eigenvalues of the normalized covariance matrix */
+        float           _totalVariance = 0; /** Trace of the normalized covariance matrix */
+    };
+
+    /// /////////////// ///
+    /// INCREMENTAL PCA ///
+    /// /////////////// ///
+
+    // Updates a decomposition with batches of rows, earlier batches are never revisited
+    // Incremental SVD update by Ross et al. (2008), like sklearn.decomposition.IncrementalPCA.partial_fit
+    // The normalization factors are fixed by the first batch, later batches are scaled with the same factors
+    // Call like:
+    /*
+    math::IncrementalPCA ipca(num_dims, num_comp, math::DATA_NORM::MINMAX);
+    ipca.partialFit(batch_0.data(), batch_0.size() / num_dims);        // row-major [p0d0, p0d1, ..., p1d0, ...]
+    ipca.transform(batch_0.data(), batch_0.size() / num_dims, out.data());
+    ...
+    ipca.partialFit(batch_1.data(), batch_1.size() / num_dims);
+    ipca.alignPrevious(out.data(), num_rows_batch_0);                    // update the projection of earlier batches
+    ipca.transform(batch_1.data(), batch_1.size() / num_dims, out.data() + num_rows_batch_0 * ipca.numComponents());
+    ...
+    if (ipca.drift() > tolerance)                                        // project all rows again once the aligned ones may be off
+    {
+        ipca.transform(all_rows.data(), ipca.numRows(), out.data());
+        ipca.resetDrift();
+    }
+    */
+    class IncrementalPCA
+    {
+    public:
+        IncrementalPCA(const size_t num_dims, const size_t num_comp, const DATA_NORM norm = DATA_NORM::NONE) :
+            _num_dims(num_dims),
+            _num_comp(std::clamp<size_t>(num_comp, 1, std::max<size_t>(num_dims, 1))),
+            _norm(norm),
+            _mean(Eigen::VectorXd::Zero(num_dims)),
+            _normFactors(Eigen::VectorXf::Ones(num_dims))
+        {
+        }
+
+        // Update the decomposition with num_rows rows of row-major data
+        // The first batch must have at least numComponents() rows, like in sklearn, such that all later batches keep that many components
+        // Returns false if the batch could not be fitted, the reason is written to status, the decomposition is unchanged then
+        bool partialFit(const float* data, const size_t num_rows, SolverStatus* status = nullptr)
+        {
+            if (num_rows == 0)
+                return true;
+
+            const Eigen::Map<const Eigen::Matrix<float, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>> batch(data, num_rows, _num_dims);
+
+            if (_num_rows == 0)
+            {
+                if (num_rows < _num_comp)
+                {
+                    setError(status, "IncrementalPCA: the first batch must have at least num_comp = " + std::to_string(_num_comp) + " rows");
+                    return false;
+                }
+
+                // after centering, both MEAN and MINMAX normalization divide each column by (max - min)
+                _normFactors = normalizationFactors(batch.colwise().minCoeff(), batch.colwise().maxCoeff(), _norm);
+            }
+
+            const Eigen::VectorXf invNormFactors = _normFactors.cwiseInverse();
+            const Eigen::VectorXd batchMean = batch.cast<double>().colwise().mean();
+            const double num_prev = static_cast<double>(_num_rows);
+            const double num_total = num_prev + static_cast<double>(num_rows);
+
+            // stack the previous decomposition, the centered batch and a correction for the shift of the mean
+            const Eigen::Index num_prev_comp = _components.cols();
+            Eigen::MatrixXf stacked(num_prev_comp + num_rows + (_num_rows > 0 ? 1 : 0), _num_dims);
+            stacked.middleRows(num_prev_comp, num_rows) = (batch.rowwise() - batchMean.cast<float>().transpose()) * invNormFactors.asDiagonal();
+
+            if (_num_rows > 0)
+            {
+                stacked.topRows(num_prev_comp) = _singularValues.asDiagonal() * _components.transpose();
+                stacked.bottomRows(1) = (std::sqrt(num_prev * num_rows / num_total) * (_mean - batchMean)).cast<float>().transpose() * invNormFactors.asDiagonal();
+            }
+
+            Eigen::BDCSVD<Eigen::MatrixXf, Eigen::ComputeThinV> svd(stacked);
+
+            if (svd.info() != Eigen::Success)
+            {
+                setError(status, "IncrementalPCA: partialFit failed. Eigen::ComputationInfo " + std::to_string(static_cast<int32_t>(svd.info())));
+                return false;
+            }
+
+            // the stacked matrix has at least as many rows as the first batch, so always numComponents() singular values
+            const Eigen::Index num_comp = static_cast<Eigen::Index>(_num_comp);
+            assert(svd.singularValues().size() >= num_comp);
+
+            _prevComponents = std::move(_components);
+            _prevMean = _mean;
+
+            _components = svd.matrixV().leftCols(num_comp);
+            _singularValues = svd.singularValues().head(num_comp);
+            _mean = (num_prev * _mean + static_cast<double>(num_rows) * batchMean) / num_total;
+            _num_rows += num_rows;
+
+            // alignPrevious misses the part of the earlier rows between the previous and the new subspace
+            if (_prevComponents.size() > 0)
+                _drift += std::sin(subspaceAngle(_prevComponents, _components));
+
+            return true;
+        }
+
+        // Normalize, center and project num_rows rows of row-major data into out, row-major num_rows x numComponents()
+        void transform(const float* data, const size_t num_rows, float* out) const
+        {
+            const Eigen::Map<const Eigen::Matrix<float, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>> batch(data, num_rows, _num_dims);
+            Eigen::Map<Eigen::Matrix<float, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>> batch_out(out, num_rows, _components.cols());
+
+            const Eigen::MatrixXf scaledComponents = _normFactors.cwiseInverse().asDiagonal() * _components;
+            batch_out.noalias() = (batch.rowwise() - _mean.cast<float>().transpose()) * scaledComponents;
+        }
+
+        // Map the projection onto the decomposition before the last partialFit to the current decomposition, in place
+        // Uses only the projections, i.e. the part of the original rows orthogonal to the previous components is neglected
+        // The error of an aligned row is at most the sine of the largest principal angle between both subspaces times its residual, see drift
+        void alignPrevious(float* transformed, const size_t num_rows) const
+        {
+            if (_prevComponents.size() == 0 || num_rows == 0)
+                return;
+
+            Eigen::Map<Eigen::Matrix<float, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>> trans(transformed, num_rows, _components.cols());
+
+            const Eigen::MatrixXf rotation = _prevComponents.transpose() * _components;
+            const Eigen::RowVectorXf shift = ((_prevMean - _mean).cast<float>().transpose() * _normFactors.cwiseInverse().asDiagonal()) * _components;
+
+            trans = (trans * rotation).rowwise() + shift;
+        }
+
+        // Flip the components such that the max abs value of each projected dimension is positive, see standardOrientation
+        // transformed is the row-major projection of all fitted rows, it is flipped in place
+        void orient(float* transformed, const size_t num_rows)
+        {
+            Eigen::Map<Eigen::Matrix<float, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>> trans(transformed, num_rows, _components.cols());
+
+            Eigen::Index rowID;
+            for (Eigen::Index colID = 0; colID < trans.cols(); colID++)
+            {
+                trans.col(colID).cwiseAbs().maxCoeff(&rowID);
+                if (trans(rowID, colID) >= 0)
+                    continue;
+
+                trans.col(colID) *= -1.0f;
+                _components.col(colID) *= -1.0f;
+            }
+        }
+
+        size_t numRows() const { return _num_rows; }
+        size_t numDims() const { return _num_dims; }
+        size_t numComponents() const { return _num_comp; }
+        DATA_NORM norm() const { return _norm; }
+        const Eigen::VectorXd& mean() const { return _mean; }
+        const Eigen::MatrixXf& components() const { return _components; }          // num_dims x num_comp
+        const Eigen::VectorXf& singularValues() const { return _singularValues; }
+
+        // Bound of the error of aligned projections relative to the residual of their rows, the sum of the sines of the largest principal angles of all updates since resetDrift
+        // Once it exceeds a tolerance, transform all fitted rows again and call resetDrift
+        double drift() const { return _drift; }
+        void resetDrift() { _drift = 0.0; }
+
+    private:
+        size_t          _num_dims;
+        size_t          _num_comp;
+        size_t          _num_rows = 0;
+        DATA_NORM       _norm;
+        Eigen::VectorXd _mean;              /** Column means of all fitted rows */
+        Eigen::VectorXf _normFactors;       /** Column scaling, fixed by the first batch */
+        Eigen::MatrixXf _components;        /** Principal components */
+        Eigen::VectorXf _singularValues;    /** Singular values of the normalized and centered fitted rows */
+        Eigen::MatrixXf _prevComponents;    /** Components before the last partialFit */
+        Eigen::VectorXd _prevMean;          /** Column means before the last partialFit */
+        double          _drift = 0.0;       /** See drift() */
+    };
+
+    // Fits model to data, see PcaModel::fit, returns false if the decomposition failed or was cancelled through solverParams.cancel
+    template<typename Scalar, typename Derived>
+    inline bool pcaFit(PcaModel<Scalar>& model, const Eigen::MatrixBase<Derived>& data, const size_t num_comp, const PCA_ALG algorithm = PCA_ALG::SVD, const DATA_NORM norm = DATA_NORM::MINMAX, const SolverParams& solverParams = {})
+    {
+        try {
+            model.fit(data, num_comp, algorithm, norm, solverParams);
+        }
+        catch (const Cancelled&) {
+            return false;
+        }
+        catch (const std::runtime_error& ex) {
+            setError(solverParams, ex.what());
+            return false;
+        }
+
+        return true;
+    }
+
+    // Projects data onto the first data_transformed.cols() components of a fitted model, no decomposition is computed
+    // data and data_transformed may be of either storage order, see pcaInto
+    // Returns false if the projection was cancelled through solverParams.cancel, the content of data_transformed is unspecified then
+    template<typename Scalar, typename Derived, typename DerivedOut>
+    inline bool pcaInto(const PcaModel<Scalar>& model, const Eigen::MatrixBase<Derived>& data, Eigen::MatrixBase<DerivedOut>& data_transformed, const bool stdOrientation = true, const SolverParams& solverParams = {})
+    {
+        assert(data_transformed.rows() == data.rows());
+        assert(static_cast<size_t>(data_transformed.cols()) <= model.numComponents());
+
+        const ProgressCallback& progress = solverParams.progress;
+
+        // orientation flips the components of this copy, model stays untouched
+        PcaModel<Scalar> truncated = model.truncated(data_transformed.cols());
+        try {
+            truncated.transform(data, data_transformed, solverParams.cancel, progress);
+        }
+        catch (const Cancelled&) {
+            return false;
+        }
+
+        // enforce same orientation (flip axis) for all algorithms, in place
+        reportProgress(progress, PHASE::ORIENT, 0.0f);
+        if (stdOrientation)
+            truncated.orient(data_transformed);
+        reportProgress(progress, PHASE::ORIENT, 1.0f);
+
+        return true;
+    }
+
+    // pcaInto for the data that model was fitted on, copies the projection that the fit kept instead of projecting data again
+    template<typename Scalar, typename Derived, typename DerivedOut>
+    inline bool pcaIntoFitted(const PcaModel<Scalar>& model, const Eigen::MatrixBase<Derived>& data, Eigen::MatrixBase<DerivedOut>& data_transformed, const bool stdOrientation = true, const SolverParams& solverParams = {})
+    {
+        if (model.fittedProjection().rows() != data.rows())
+            return pcaInto(model, data, data_transformed, stdOrientation, solverParams);
+
+        const ProgressCallback& progress = solverParams.progress;
+
+        PcaModel<Scalar> truncated = model.truncated(data_transformed.cols());
+        reportProgress(progress, PHASE::PROJECT, 0.0f);
+        data_transformed = truncated.fittedProjection();
+        reportProgress(progress, PHASE::PROJECT, 1.0f);
+
+        reportProgress(progress, PHASE::ORIENT, 0.0f);
+        if (stdOrientation)
+            truncated.orient(data_transformed);
+        reportProgress(progress, PHASE::ORIENT, 1.0f);
+
+        return true;
+    }
+
+    // Core of the pca: data and data_transformed may be of either storage order, e.g. Eigen::Map views of caller-owned buffers
+    // Everything is computed in the scalar type of data, which data_transformed must share, no conversion copies are made
+    // data_transformed must be num_row x num_comp and num_comp must be valid, see checkNumComponents
+    // With solverParams.varianceFraction, the columns beyond the selected components are zero, use pca() to get their number
+    // Returns false if the computation failed or was cancelled through solverParams.cancel
+    template<typename Derived, typename DerivedOut>
+    inline bool pcaInto(const Eigen::MatrixBase<Derived>& data, Eigen::MatrixBase<DerivedOut>& data_transformed, const size_t num_comp, const PCA_ALG algorithm = PCA_ALG::SVD, const DATA_NORM norm = DATA_NORM::MINMAX, const bool stdOrientation = true, const SolverParams& solverParams = {})
+    {
+        using Scalar = typename Derived::Scalar;
+
+        static_assert(std::is_same_v<Scalar, typename DerivedOut::Scalar>, "pcaInto: input and output must have the same scalar type");
+
+        assert(static_cast<size_t>(data_transformed.cols()) == num_comp);
+
+        // the working matrix of the fit is released before the projection, which is written straight into the output
+        PcaModel<Scalar> model;
+        if (!pcaFit(model, data, num_comp, algorithm, norm, solverParams))
+        {
+            // the content of data_transformed is unspecified after a cancellation
+            if (!isCancelled(solverParams.cancel))
+                data_transformed.setZero();
+            return false;
+        }
+
+        if (model.numComponents() < num_comp)
+        {
+            data_transformed.rightCols(num_comp - model.numComponents()).setZero();
+            auto data_selected = data_transformed.leftCols(model.numComponents());
+            return pcaIntoFitted(model, data, data_selected, stdOrientation, solverParams);
+        }
+
+        return pcaIntoFitted(model, data, data_transformed, stdOrientation, solverParams);
+    }
+
+    // data_in is row-major [p0d0, p0d1, ..., p1d0, p1d1, ..., pNd0, pNd1, ..., pNdM] and is read in place
+    // The projection is written once, directly into pca_out with the same layout, which must hold num_row * num_comp values
+    // Scalar (float or double) is taken from pca_out, data_in must have the same scalar type
+    // num_comp must be valid, see checkNumComponents
+    template<typename Scalar>
+    inline bool pcaInto(std::type_identity_t<std::span<const Scalar>> data_in, const size_t num_dims, std::span<Scalar> pca_out, const size_t num_comp, const PCA_ALG algorithm = PCA_ALG::SVD, const DATA_NORM norm = DATA_NORM::MINMAX, const bool stdOrientation = true, const SolverParams& solverParams = {})
+    {
+        // view std span as Eigen matrix, no copy
+        const Eigen::Map<const RowMajorMatrix<Scalar>> data = mapRowMajor(data_in, num_dims);
+        Eigen::Map<RowMajorMatrix<Scalar>> data_transformed(pca_out.data(), data.rows(), num_comp);
+
+        assert(static_cast<size_t>(data.rows()) * num_dims == data_in.size());
+        assert(static_cast<size_t>(data.rows()) * num_comp == pca_out.size());
+
+        return pcaInto(data, data_transformed, num_comp, algorithm, norm, stdOrientation, solverParams);
+    }
+
+    // pca_out is resized to num_row * num_comp and has the layout [p0d0, p0d1, ..., p1d0, p1d1, ..., pNd0, pNd1, ..., pNdM]
+    // data_in can be a std::vector or std::span of float or double, matching pca_out
+    // num_comp is set to the number of computed components, with solverParams.varianceFraction num_comp is the upper bound on input
+    template<typename Scalar>
+    inline bool pca(std::type_identity_t<std::span<const Scalar>> data_in, const size_t num_dims, std::vector<Scalar>& pca_out, size_t& num_comp, const PCA_ALG algorithm = PCA_ALG::SVD, const DATA_NORM norm = DATA_NORM::MINMAX, const bool stdOrientation = true, const SolverParams& solverParams = {})
+    {
+        // do not transform if data is 1d
+        if (num_dims <= 1)
+        {
+            num_comp = num_dims;
+            pca_out.assign(data_in.begin(), data_in.end());
+            std::cout << "pca: num_dims == 1, no transformation is performed" << std::endl;;
+            return false;
+        }
+
+        // check number of component against number of rows and columns
+        const size_t num_row = data_in.size() / num_dims;
+        checkNumComponents(num_row, num_dims, num_comp);
+
+        // the number of components is only known after the fit
+        if (useVarianceFraction(solverParams))
+        {
+            const auto data = mapRowMajor(data_in, num_dims);
+
+            PcaModel<Scalar> model;
+            if (!pcaFit(model, data, num_comp, algorithm, norm, solverParams))
+            {
+                if (!isCancelled(solverParams.cancel))
+                    pca_out.assign(num_row * num_comp, Scalar(0));
+                return false;
+            }
+
+            num_comp = model.numComponents();
+            pca_out.resize(num_row * num_comp);
+            Eigen::Map<RowMajorMatrix<Scalar>> data_transformed(pca_out.data(), num_row, num_comp);
+
+            return pcaIntoFitted(model, data, data_transformed, stdOrientation, solverParams);
+        }
+
+        pca_out.resize(num_row * num_comp);
+
+        return pcaInto(data_in, num_dims, std::span<Scalar>(pca_out), num_comp, algorithm, norm, stdOrientation, solverParams);
+    }
 }
 
 #endif // PCA_H
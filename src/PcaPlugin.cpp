@@ -1,13 +1,17 @@
 #include "PcaPlugin.h"
 
-#include "PCA.h"
-
+#include <ClusterData/ClusterData.h>
 #include <PointData/InfoAction.h>
 #include <PointData/PointData.h>
 
 #include <algorithm>
+#include <cassert>
+#include <cmath>
 #include <iostream>
+#include <numbers>
+#include <numeric>
 #include <ostream>
+#include <utility>
 
 Q_PLUGIN_METADATA(IID "studio.manivault.PCAPlugin")
 
@@ -29,6 +33,9 @@ static math::PCA_ALG getPcaAlgorithm(size_t index) {
     case 1:
         alg = math::PCA_ALG::SVD;
         break;
+    case 2:
+        alg = math::PCA_ALG::RANDOMIZED;
+        break;
     }
 
     return alg;
@@ -41,6 +48,8 @@ static std::ostream& operator<<(std::ostream& o, math::PCA_ALG alg)
         return o << "COV";
     if (alg == math::PCA_ALG::SVD)
         return o << "SVD";
+    if (alg == math::PCA_ALG::RANDOMIZED)
+        return o << "RANDOMIZED";
 
     return o;
 }
@@ -79,31 +88,580 @@ static std::ostream& operator<<(std::ostream& o, math::DATA_NORM norm)
 }
 
 
+static math::PRECISION getPrecision(size_t index) {
+    return (index == 1) ? math::PRECISION::MIXED : math::PRECISION::SINGLE;
+}
+
+static math::FIT_SAMPLE getFitSampleStrategy(size_t index) {
+    switch (index)
+    {
+    case 1:     return math::FIT_SAMPLE::UNIFORM;
+    case 2:     return math::FIT_SAMPLE::STRATIFIED;
+    default:    return math::FIT_SAMPLE::ALL_POINTS;
+    }
+}
+
+// Seeds of the fit sample and the second sample of the quality check
+static constexpr uint32_t fitSampleSeed = 0;
+static constexpr uint32_t checkSampleSeed = 1;
+
+static QString getPhaseDescription(math::PHASE phase) {
+    switch (phase)
+    {
+    case math::PHASE::EXTRACT:      return "Extracting data";
+    case math::PHASE::NORMALIZE:    return "Normalizing";
+    case math::PHASE::CENTER:       return "Centering";
+    case math::PHASE::DECOMPOSE:    return "Decomposing";
+    case math::PHASE::PROJECT:      return "Projecting";
+    case math::PHASE::ORIENT:       return "Orienting";
+    case math::PHASE::PUBLISH:      return "Publishing";
+    }
+
+    return "Computing...";
+}
+
+// Overall progress, all phases are weighted equally
+static float getOverallProgress(math::PHASE phase, float fraction) {
+    constexpr float numPhases = static_cast<float>(math::PHASE::PUBLISH) + 1.0f;
+    return (static_cast<float>(phase) + std::clamp(fraction, 0.0f, 1.0f)) / numPhases;
+}
+
+// Number of components of a new decomposition
+// Full decompositions yield all components at no extra cost, keep them such that a later change of the number of components only projects
+static size_t getNumFitComponents(math::PCA_ALG alg, size_t num_comps, size_t num_points, size_t num_dims, const math::SolverParams& solverParams) {
+    const size_t num_all = std::min(num_points, num_dims);
+
+    if (alg == math::PCA_ALG::SVD)
+        return num_all;
+
+    if (alg == math::PCA_ALG::COV && !math::usePartialEigensolver(num_dims, num_comps, solverParams))
+        return num_all;
+
+    return num_comps;
+}
+
+// Memory limit of the cached scatter matrix of all dimensions, see PCAPlugin::canUseScatterStatistics
+static constexpr size_t maxScatterStatisticsBytes = size_t{ 1 } << 28;
+
+// Memory of the cached statistics of all dimensions, while they are accumulated also the extraction of all dimensions and the per-thread scatter matrices
+static size_t getScatterStatisticsBytes(size_t num_points, size_t num_all_dims, bool accumulate) {
+    const size_t scatterBytes = num_all_dims * num_all_dims * sizeof(double);
+
+    if (!accumulate)
+        return scatterBytes;
+
+    // the accumulator, the statistics of the extracted chunk and the scatter kernel's accumulators
+    const size_t threads = static_cast<size_t>(math::scatterThreads(static_cast<Eigen::Index>(num_all_dims), sizeof(double)));
+    return num_points * num_all_dims * sizeof(float) + (threads + 2) * scatterBytes;
+}
+
+// Minimal time between two progress updates of the GUI
+static constexpr std::chrono::milliseconds progressInterval{ 100 };
+
+// Bound of math::IncrementalPCA::drift, beyond it the next incremental update projects all points again
+static constexpr double incrementalDriftTolerance = 0.05;
+
+// Number of parent rows that are projected at once, see PCAWorker::projectWithParent
+static constexpr size_t parentChunkRows = size_t{ 1 } << 16;
+
+// Number of points of a full data set or a subset, the subset is what is extracted and published
+static size_t getNumDataPoints(const Dataset<Points>& dataset) {
+    return dataset->isFull() ? static_cast<size_t>(dataset->getNumPoints()) : dataset->indices.size();
+}
+
+// Stratum of each point of the input: the index of its cluster, points in none of the clusters form the last stratum
+// Cluster indices refer to the points that the clusters belong to, those and the input are matched by their rows in the full data set
+// Empty if the clusters belong to another full data set, the sample is then drawn uniformly
+static std::vector<uint32_t> getStrataLabels(const Dataset<Clusters>& clusters, const Dataset<Points>& inputDataset) {
+    const auto clustersParent = clusters->getParent();
+    if (!clustersParent.isValid() || clustersParent->getDataType() != PointType)
+        return {};
+
+    const auto clusterPoints = Dataset<Points>(clustersParent);
+    if (clusterPoints->getFullDataset<Points>()->getId() != inputDataset->getFullDataset<Points>()->getId())
+        return {};
+
+    const size_t num_points = getNumDataPoints(inputDataset);
+    const size_t num_cluster_points = getNumDataPoints(clusterPoints);
+    const auto clusterRow = [&clusterPoints](uint32_t index) -> uint32_t { return clusterPoints->isFull() ? index : clusterPoints->indices[index]; };
+    const auto inputRow = [&inputDataset](uint32_t position) -> uint32_t { return inputDataset->isFull() ? position : inputDataset->indices[position]; };
+
+    // input positions ordered by their row in the full data set, a subset is not assumed to be sorted
+    std::vector<uint32_t> positions(num_points);
+    std::iota(positions.begin(), positions.end(), 0u);
+    if (!inputDataset->isFull())
+        std::sort(positions.begin(), positions.end(), [&inputRow](uint32_t a, uint32_t b) { return inputRow(a) < inputRow(b); });
+
+    const auto& clusterList = clusters->getClusters();
+    std::vector<uint32_t> labels(num_points, static_cast<uint32_t>(clusterList.size()));
+
+    for (uint32_t clusterId = 0; clusterId < static_cast<uint32_t>(clusterList.size()); clusterId++)
+        for (const auto index : clusterList[clusterId].getIndices())
+        {
+            if (index >= num_cluster_points)
+                continue;
+
+            const uint32_t row = clusterRow(index);
+            const auto match = std::lower_bound(positions.begin(), positions.end(), row, [&inputRow](uint32_t position, uint32_t value) { return inputRow(position) < value; });
+            if (match != positions.end() && inputRow(*match) == row)
+                labels[*match] = clusterId;
+        }
+
+    return labels;
+}
+
 /// ////////// ///
 /// PCA WORKER ///
 /// ////////// ///
-PCAWorker::PCAWorker(std::shared_ptr<std::vector<float>> data, size_t num_dims, size_t num_comps, math::PCA_ALG algorithm, math::DATA_NORM norm, bool std_orient) :
+PCAWorker::PCAWorker(std::shared_ptr<std::vector<float>> data, size_t num_dims, size_t num_comps, math::PCA_ALG algorithm, math::DATA_NORM norm, bool std_orient, math::SolverParams solver_params) :
     _data(data), 
     _num_dims(num_dims),
     _num_comps(num_comps), 
     _std_orient(std_orient),
     _algorithm(algorithm),
-    _norm(norm)
+    _norm(norm),
+    _solver_params(solver_params)
+{
+    _solver_params.progress = [this](math::PHASE phase, float fraction) { reportProgress(phase, fraction); };
+    _solver_params.status = &_status;
+}
+
+void PCAWorker::setIncremental(std::shared_ptr<math::IncrementalPCA> ipca, std::vector<float>&& pca_prev, bool reproject)
+{
+    _ipca = ipca;
+    _pca_out = std::move(pca_prev);
+    _reproject = reproject;
+}
+
+void PCAWorker::setDecomposition(std::shared_ptr<const math::PcaModel<float>> model, size_t num_fit_comps)
+{
+    _model = model;
+    _num_fit_comps = num_fit_comps;
+}
+
+void PCAWorker::setNumThreads(int num_threads)
 {
+    _num_threads = num_threads;
+}
+
+void PCAWorker::setFitSample(math::FIT_SAMPLE strategy, size_t sampleSize, bool qualityCheck, std::vector<uint32_t>&& labels)
+{
+    _fitSampleStrategy = strategy;
+    _fitSampleSize = sampleSize;
+    _sampleQualityCheck = qualityCheck;
+    _labels = std::move(labels);
+}
+
+void PCAWorker::setParentProjection(std::vector<float>&& parentData)
+{
+    _parent_data = std::move(parentData);
+}
+
+void PCAWorker::setLiveUpdate(LiveState previous, std::vector<float>&& pca_prev, double driftTolerance)
+{
+    _useLiveUpdate = true;
+    _live = std::move(previous);
+    _pca_out = std::move(pca_prev);
+    _driftTolerance = driftTolerance;
 }
 
 void PCAWorker::compute() {
     bool pca_success = false;
 
+#ifdef _OPENMP
+    // applies to the parallel regions started from this thread
+    if (_num_threads > 0)
+        omp_set_num_threads(_num_threads);
+#endif
+
     utils::timer([&]() {
-        pca_success = math::pca(*_data, /* number of dimension = */ _num_dims, /* transformed PCA data = */ _pca_out, /* number of pca components = */ _num_comps,
-                                       /* pca algorithm = */ _algorithm, /* data normalization = */ _norm, /* stdOrientation = */ _std_orient);
+        if (_ipca)
+            pca_success = updateIncremental();
+        else if (_useLiveUpdate)
+            pca_success = updateLive();
+        else if (_useScatterStatistics)
+            pca_success = computeFromScatterStatistics();
+        else
+            pca_success = computeFromModel();
         },
         "PCA computation time (ms)");
 
+    // release the working memory of a cancelled computation right away
+    if (!pca_success && math::isCancelled(_solver_params.cancel))
+    {
+        _data.reset();
+        std::vector<float>().swap(_pca_out);
+        std::vector<float>().swap(_parent_out);
+    }
+
+    // the plugin keeps the results, the core takes over the copy
+    if (pca_success && _copyResults)
+        _pca_out_copy = _pca_out;
+
     emit resultReady(pca_success);
 }
 
+void PCAWorker::setScatterStatistics(std::shared_ptr<const math::CovarianceAccumulator> stats, const std::vector<unsigned int>& dimensions)
+{
+    _useScatterStatistics = true;
+    _scatterStatistics = stats;
+    _scatterDimensions = dimensions;
+}
+
+bool PCAWorker::computeFromScatterStatistics()
+{
+    const size_t num_points = _data->size() / _num_dims;
+    const size_t num_selected_dims = _scatterDimensions.size();
+    const auto data = math::mapRowMajor(*_data, _num_dims);
+
+    math::checkNumComponents(num_points, num_selected_dims, _num_comps);
+
+    // accumulate the statistics of all dimensions once, the data contains all dimensions in that case
+    if (!_scatterStatistics)
+    {
+        auto stats = std::make_shared<math::CovarianceAccumulator>(_num_dims);
+        try {
+            stats->addChunk(_data->data(), num_points, _solver_params.cancel, _solver_params.progress);
+        }
+        catch (const math::Cancelled&) {
+            return false;
+        }
+
+        _scatterStatistics = std::move(stats);
+    }
+
+    // principal submatrix of the selected dimensions, only the eigendecomposition remains
+    math::CovarianceAccumulator selected = _scatterStatistics->subset(_scatterDimensions);
+
+    size_t num_fit_comps = std::max(_num_fit_comps, _num_comps);
+    math::checkNumComponents(num_points, num_selected_dims, num_fit_comps);
+
+    reportProgress(math::PHASE::DECOMPOSE, 0.0f);
+    if (!selected.finalize(num_fit_comps, _norm, _solver_params))
+    {
+        if (!math::isCancelled(_solver_params.cancel))
+            _pca_out.assign(num_points * _num_comps, 0.0f);
+        return false;
+    }
+    reportProgress(math::PHASE::DECOMPOSE, 1.0f);
+
+    _model = std::make_shared<math::PcaModel<float>>(selected.model());
+    _num_comps = std::min(_num_comps, _model->numComponents());
+
+    // project straight into the output buffer, picking the selected dimensions if all were extracted
+    _pca_out.resize(num_points * _num_comps);
+    Eigen::Map<math::RowMajorMatrixXf> pca_out(_pca_out.data(), num_points, _num_comps);
+
+    if (_num_dims == num_selected_dims)
+        return math::pcaInto(*_model, data, pca_out, _std_orient, _solver_params);
+    else
+        return math::pcaInto(*_model, data(Eigen::placeholders::all, _scatterDimensions), pca_out, _std_orient, _solver_params);
+}
+
+bool PCAWorker::computeFromModel()
+{
+    // nothing to decompose
+    if (_num_dims <= 1)
+        return math::pca(*_data, /* number of dimension = */ _num_dims, /* transformed PCA data = */ _pca_out, /* number of pca components = */ _num_comps,
+                                /* pca algorithm = */ _algorithm, /* data normalization = */ _norm, /* stdOrientation = */ _std_orient, /* solver parameters = */ _solver_params);
+
+    const size_t num_points = _data->size() / _num_dims;
+    math::checkNumComponents(num_points, _num_dims, _num_comps);
+
+    const auto data = math::mapRowMajor(*_data, _num_dims);
+
+    // fit unless the plugin passed a decomposition of the same data and settings
+    if (!_model)
+    {
+        size_t num_fit_comps = std::max(_num_fit_comps, _num_comps);
+        math::checkNumComponents(num_points, _num_dims, num_fit_comps);
+
+        // the strata are only needed to draw the samples
+        if (_fitSampleStrategy != math::FIT_SAMPLE::ALL_POINTS)
+        {
+            _fitSample = math::fitSampleRows(_fitSampleStrategy, num_points, _fitSampleSize, _labels, fitSampleSeed);
+            if (_sampleQualityCheck)
+                _checkSample = math::fitSampleRows(_fitSampleStrategy, num_points, _fitSampleSize, _labels, checkSampleSeed);
+
+            _labels = {};
+        }
+
+        auto model = std::make_shared<math::PcaModel<float>>();
+        bool fit_success = false;
+        if (_fitSample.empty())
+            fit_success = math::pcaFit(*model, data, num_fit_comps, _algorithm, _norm, _solver_params);
+        else
+        {
+            // only the sample is decomposed, its copy is released before all points are projected
+            const math::RowMajorMatrixXf sample = math::sampleRows(data, _fitSample);
+            math::checkNumComponents(sample.rows(), _num_dims, num_fit_comps);
+            fit_success = math::pcaFit(*model, sample, num_fit_comps, _algorithm, _norm, _solver_params);
+        }
+
+        if (!fit_success)
+        {
+            if (!math::isCancelled(_solver_params.cancel))
+                _pca_out.assign(num_points * _num_comps, 0.0f);
+            return false;
+        }
+
+        // quality check: a sample that is large enough yields the same components for another sample
+        if (!_checkSample.empty())
+        {
+            const math::RowMajorMatrixXf checkSample = math::sampleRows(data, _checkSample);
+            math::PcaModel<float> checkModel;
+            const size_t num_check_comps = std::min(_num_comps, model->numComponents());
+            if (math::pcaFit(checkModel, checkSample, num_check_comps, _algorithm, _norm, _solver_params))
+                _sampleSubspaceAngle = math::subspaceAngle(model->components().leftCols(num_check_comps), checkModel.components().leftCols(std::min(num_check_comps, checkModel.numComponents())));
+            else if (math::isCancelled(_solver_params.cancel))
+                return false;
+        }
+
+        _model = std::move(model);
+    }
+
+    // the explained variance may select fewer components
+    _num_comps = std::min(_num_comps, _model->numComponents());
+
+    // project straight into the output buffer
+    _pca_out.resize(num_points * _num_comps);
+    Eigen::Map<math::RowMajorMatrixXf> pca_out(_pca_out.data(), num_points, _num_comps);
+
+    if (!_parent_data.empty())
+        return projectWithParent(data, pca_out);
+
+    // a fit on the Gram matrix of all points already yields their projection
+    if (_fitSample.empty())
+        return math::pcaIntoFitted(*_model, data, pca_out, _std_orient, _solver_params);
+
+    return math::pcaInto(*_model, data, pca_out, _std_orient, _solver_params);
+}
+
+bool PCAWorker::projectWithParent(const Eigen::Map<const math::RowMajorMatrixXf>& data, Eigen::Map<math::RowMajorMatrixXf>& pca_out)
+{
+    const size_t num_points = data.rows();
+    const size_t num_parent_rows = _parent_data.size() / _num_dims;
+
+    // the progress of the projection is split between the subset and the parent by their number of points
+    const float subsetShare = static_cast<float>(num_points) / static_cast<float>(num_points + num_parent_rows);
+    const math::ProgressCallback subsetProgress = [this, subsetShare](math::PHASE phase, float fraction) { reportProgress(phase, fraction * subsetShare); };
+
+    // the orientation is determined by the subset that was fitted, the parent is projected with the flipped components
+    math::PcaModel<float> projection = _model->truncated(_num_comps);
+    _parent_out.resize(num_parent_rows * _num_comps);
+
+    try {
+        projection.transform(data, pca_out, _solver_params.cancel, subsetProgress);
+        if (_std_orient)
+            projection.orient(pca_out);
+
+        // the parent is projected chunk by chunk to report progress, each chunk is projected in parallel
+        for (size_t first = 0; first < num_parent_rows; first += parentChunkRows)
+        {
+            math::throwIfCancelled(_solver_params.cancel);
+
+            const size_t count = std::min(parentChunkRows, num_parent_rows - first);
+            const Eigen::Map<const math::RowMajorMatrixXf> rows(_parent_data.data() + first * _num_dims, count, _num_dims);
+            Eigen::Map<math::RowMajorMatrixXf> parent_out(_parent_out.data() + first * _num_comps, count, _num_comps);
+            projection.transform(rows, parent_out, _solver_params.cancel);
+
+            reportProgress(math::PHASE::PROJECT, subsetShare + (1.0f - subsetShare) * static_cast<float>(first + count) / static_cast<float>(num_parent_rows));
+        }
+    }
+    catch (const math::Cancelled&) {
+        return false;
+    }
+
+    // the parent rows are not needed for the results
+    _parent_data = {};
+
+    reportProgress(math::PHASE::ORIENT, 1.0f);
+
+    return true;
+}
+
+void PCAWorker::reportProgress(math::PHASE phase, float fraction)
+{
+    const auto now = std::chrono::steady_clock::now();
+
+    if (phase == _lastProgressPhase && fraction < 1.0f && now - _lastProgressTime < progressInterval)
+        return;
+
+    _lastProgressTime = now;
+    _lastProgressPhase = phase;
+
+    emit progressChanged(getOverallProgress(phase, fraction), getPhaseDescription(phase));
+}
+
+bool PCAWorker::updateIncremental()
+{
+    const size_t num_prev = _ipca->numRows();
+    const size_t num_rows = _data->size() / _num_dims;
+
+    // the data contains the earlier rows as well if they are projected again
+    const size_t first_new = _reproject ? num_prev : 0;
+    const size_t num_new = num_rows - first_new;
+    const float* data_new = _data->data() + first_new * _num_dims;
+
+    if (math::isCancelled(_solver_params.cancel))
+        return false;
+
+    reportProgress(math::PHASE::DECOMPOSE, 0.0f);
+
+    // the decomposition and the previous projection stay as they are, the plugin keeps publishing them
+    if (!_ipca->partialFit(data_new, num_new, &_status))
+        return false;
+
+    // the decomposition is already updated, the plugin discards it if the update is cancelled here
+    if (math::isCancelled(_solver_params.cancel))
+        return false;
+
+    _num_comps = _ipca->numComponents();
+    _pca_out.resize(_ipca->numRows() * _num_comps);
+
+    reportProgress(math::PHASE::PROJECT, 0.0f);
+    if (_reproject)
+    {
+        // the aligned projection drifted too far from the exact one, all rows are projected onto the updated basis
+        _ipca->transform(_data->data(), num_rows, _pca_out.data());
+        _ipca->resetDrift();
+    }
+    else
+    {
+        // rotate the projection of the earlier points into the updated basis, only the new points are projected
+        _ipca->alignPrevious(_pca_out.data(), num_prev);
+        _ipca->transform(data_new, num_new, _pca_out.data() + num_prev * _num_comps);
+    }
+
+    reportProgress(math::PHASE::ORIENT, 0.0f);
+    if (_std_orient)
+        _ipca->orient(_pca_out.data(), _ipca->numRows());
+    reportProgress(math::PHASE::ORIENT, 1.0f);
+
+    return true;
+}
+
+bool PCAWorker::updateLive()
+{
+    const size_t num_points = _data->size() / _num_dims;
+    const auto data = math::mapRowMajor(*_data, _num_dims);
+
+    math::checkNumComponents(num_points, _num_dims, _num_comps);
+
+    // the old values of changed and removed rows are downdated, the new values of changed and appended rows are updated
+    std::vector<Eigen::Index> changed;
+    std::vector<Eigen::Index> removed;
+    bool accumulate = !_live.statistics || !_live.data;
+
+    if (!accumulate)
+    {
+        const size_t num_prev = _live.data->size() / _num_dims;
+        changed = math::changedRows<float>(*_live.data, *_data, _num_dims);
+
+        for (const Eigen::Index row : changed)
+            if (static_cast<size_t>(row) < num_prev)
+                removed.push_back(row);
+        for (size_t row = num_points; row < num_prev; row++)
+            removed.push_back(static_cast<Eigen::Index>(row));
+
+        // each downdated or updated row costs as much as accumulating a row
+        accumulate = removed.size() + changed.size() >= num_points;
+    }
+
+    auto stats = std::make_shared<math::CovarianceAccumulator>(_num_dims);
+    try {
+        if (!accumulate)
+        {
+            *stats = *_live.statistics;
+
+            const math::RowMajorMatrixXf oldRows = math::sampleRows(math::mapRowMajor(*_live.data, _num_dims), removed);
+            const bool extremaExact = stats->removeChunk(oldRows.data(), oldRows.rows(), _solver_params.cancel, _solver_params.progress);
+
+            const math::RowMajorMatrixXf newRows = math::sampleRows(data, changed);
+            stats->addChunk(newRows.data(), newRows.rows(), _solver_params.cancel, _solver_params.progress);
+
+            // the normalization needs the exact extrema, which the removed rows may have held
+            accumulate = !extremaExact && _norm != math::DATA_NORM::NONE;
+        }
+
+        if (accumulate)
+        {
+            *stats = math::CovarianceAccumulator(_num_dims);
+            stats->addChunk(_data->data(), num_points, _solver_params.cancel, _solver_params.progress);
+        }
+    }
+    catch (const math::Cancelled&) {
+        return false;
+    }
+
+    size_t num_fit_comps = std::max(_num_fit_comps, _num_comps);
+    math::checkNumComponents(num_points, _num_dims, num_fit_comps);
+
+    reportProgress(math::PHASE::DECOMPOSE, 0.0f);
+    if (!stats->finalize(num_fit_comps, _norm, _solver_params))
+    {
+        if (!math::isCancelled(_solver_params.cancel))
+            _pca_out.assign(num_points * _num_comps, 0.0f);
+        return false;
+    }
+    reportProgress(math::PHASE::DECOMPOSE, 1.0f);
+
+    _model = std::make_shared<math::PcaModel<float>>(stats->model());
+    _num_comps = std::min(_num_comps, _model->numComponents());
+
+    // the previous components are kept while they drift less than the tolerance, then only the changed rows are projected
+    const auto& prevProjection = _live.projection;
+    bool keepProjection = !accumulate && prevProjection
+        && prevProjection->numComponents() == _num_comps
+        && _pca_out.size() == (_live.data->size() / _num_dims) * _num_comps
+        && prevProjection->normFactors() == _model->normFactors();
+
+    if (keepProjection)
+    {
+        const double angle = math::subspaceAngle(prevProjection->components(), _model->components().leftCols(_num_comps));
+        const double meanShift = (prevProjection->mean() - _model->mean()).cwiseQuotient(_model->normFactors()).norm();
+        keepProjection = angle <= _driftTolerance && meanShift <= _driftTolerance * std::sqrt(static_cast<double>(_model->totalVariance()));
+    }
+
+    reportProgress(math::PHASE::PROJECT, 0.0f);
+    if (keepProjection)
+    {
+        _pca_out.resize(num_points * _num_comps);
+        const math::RowMajorMatrixXf changedOut = prevProjection->transform(math::sampleRows(data, changed));
+
+#pragma omp parallel for
+        for (int64_t i = 0; i < static_cast<int64_t>(changed.size()); i++)
+            std::copy_n(changedOut.data() + i * _num_comps, _num_comps, _pca_out.data() + changed[i] * _num_comps);
+
+        reportProgress(math::PHASE::ORIENT, 1.0f);
+    }
+    else
+    {
+        // the orientation of the new components is fixed by all rows, later updates keep it
+        math::PcaModel<float> projection = _model->truncated(_num_comps);
+        _pca_out.resize(num_points * _num_comps);
+        Eigen::Map<math::RowMajorMatrixXf> pca_out(_pca_out.data(), num_points, _num_comps);
+
+        try {
+            projection.transform(data, pca_out, _solver_params.cancel, _solver_params.progress);
+        }
+        catch (const math::Cancelled&) {
+            return false;
+        }
+
+        reportProgress(math::PHASE::ORIENT, 0.0f);
+        if (_std_orient)
+            projection.orient(pca_out);
+        reportProgress(math::PHASE::ORIENT, 1.0f);
+
+        _live.projection = std::make_shared<math::PcaModel<float>>(std::move(projection));
+    }
+
+    _live.data = _data;
+    _live.statistics = std::move(stats);
+
+    return true;
+}
 
 /// ////// ///
 /// PLUGIN ///
@@ -119,6 +677,16 @@ PCAPlugin::PCAPlugin(const PluginFactory* factory) :
     setSerializationName("PCAPlugin");
 }
 
+PCAPlugin::~PCAPlugin()
+{
+    // Stop a running computation before the worker thread is destroyed
+    _cancellation.cancel();
+    _workerThread.quit();
+    _workerThread.wait();
+
+    PCAScheduler::instance().release(_scheduledJob);
+}
+
 void PCAPlugin::init()
 {
     const auto inputDataset = getInputDataset<Points>();
@@ -130,12 +698,10 @@ void PCAPlugin::init()
         auto newOutput = Dataset<Points>(mv::data().createDerivedDataset("PCA", inputDataset, inputDataset));
         setOutputDataset(newOutput);
 
-        // Set initial data (default 2 dimensions, all points at (0,0) )
-        std::vector<float> initialData;
+        // Set initial data (default 2 dimensions, all points at (0,0) ), one point per point of a subset input
         const size_t numInitialDataDimensions = 2;
-        const auto numPoints = inputDataset->getNumPoints();
-        initialData.resize(numInitialDataDimensions * numPoints);
-        newOutput->setData(initialData.data(), numPoints, numInitialDataDimensions);
+        const size_t numPoints = getNumDataPoints(inputDataset);
+        newOutput->setData(std::vector<float>(numInitialDataDimensions * numPoints), numInitialDataDimensions);
         events().notifyDatasetDataChanged(newOutput);
     }
 
@@ -155,7 +721,7 @@ void PCAPlugin::init()
     outputDataset->getDataHierarchyItem().select();
     outputDataset->_infoAction->collapse();
     
-    if (inputDataset->getNumPoints() > static_cast<uint32_t>(std::numeric_limits<int32_t>::max()))
+    if (getNumDataPoints(inputDataset) > static_cast<uint32_t>(std::numeric_limits<int32_t>::max()))
     {
         std::cerr << "PCA: can only handle data with up to std::numeric_limits<uint32_t>::max() points" << std::endl;
         _settingsAction.getStartAnalysisAction().setDisabled(true);
@@ -164,16 +730,185 @@ void PCAPlugin::init()
     // Start the analysis when the user clicks the start analysis push button
     connect(&_settingsAction.getStartAnalysisAction(), &mv::gui::TriggerAction::triggered, this, &PCAPlugin::computePCA);
 
+    // Cancel a running computation when the user aborts the task, the worker stops at its next check
+    auto& task = outputDataset->getTask();
+    task.setMayKill(true);
+    connect(&task, &Task::requestAbort, this, [this]() {
+        _cancellation.cancel();
+        }, Qt::DirectConnection);
+
+    connect(&task, &Task::requestAbort, this, [this, &task]() {
+        // An analysis that still waits for the scheduler is removed from its queue
+        if (PCAScheduler::instance().isQueued(_scheduledJob))
+        {
+            PCAScheduler::instance().release(_scheduledJob);
+            _scheduledJob = 0;
+            task.setAborted();
+            task.setProgressDescription("Computation cancelled");
+            _settingsAction.getStartAnalysisAction().setEnabled(true);
+        }
+        });
+
+    // Only cluster datasets can define the strata of the fit sample
+    _settingsAction.getStrataClusters().setFilterFunction([](const mv::Datasets& datasets) -> mv::Datasets {
+        mv::Datasets clusterDatasets;
+        for (const auto& dataset : datasets)
+            if (dataset->getDataType() == ClusterType)
+                clusterDatasets << dataset;
+        return clusterDatasets;
+        });
+
+    // The memory budget and the number of concurrent analyses are shared by all PCA analyses
+    _settingsAction.getMemoryBudget().setValue(static_cast<int>(PCAScheduler::instance().getMemoryBudget() >> 20));
+    connect(&_settingsAction.getMemoryBudget(), &mv::gui::IntegralAction::valueChanged, this, [](std::int32_t megabytes) {
+        PCAScheduler::instance().setMemoryBudget(static_cast<size_t>(megabytes) << 20);
+        });
+
+    _settingsAction.getMaxConcurrentAnalyses().setValue(static_cast<int>(PCAScheduler::instance().getMaxConcurrentJobs()));
+    connect(&_settingsAction.getMaxConcurrentAnalyses(), &mv::gui::IntegralAction::valueChanged, this, [](std::int32_t num_jobs) {
+        PCAScheduler::instance().setMaxConcurrentJobs(static_cast<size_t>(num_jobs));
+        });
+
+    // The statistics of all dimensions are only kept while the cache is enabled
+    connect(&_settingsAction.getCacheCovariance(), &mv::gui::ToggleAction::toggled, this, [this](bool checked) {
+        if (!checked)
+            _scatterStatistics.reset();
+        });
+
+    // Only a subset has a parent whose other points can be projected
+    _settingsAction.getProjectFullParent().setEnabled(!inputDataset->isFull());
+
+    // In live mode, a burst of changes of the input starts one analysis after the last change
+    _liveUpdateTimer.setSingleShot(true);
+    connect(&_liveUpdateTimer, &QTimer::timeout, this, [this]() {
+        // A running analysis schedules the update once it is done
+        if (_scheduledJob != 0)
+        {
+            _liveUpdatePending = true;
+            return;
+        }
+
+        if (_settingsAction.getStartAnalysisAction().isEnabled())
+            computePCA();
+        });
+
     // Publish a copy of the output data set
     connect(&_settingsAction.getPublishNewDataAction(), &mv::gui::TriggerAction::triggered, this, &PCAPlugin::publishCopy);
 
     // Update dimension selection with new data
     connect(&inputDataset, &Dataset<Points>::dataChanged, this, [this, inputDataset]() {
         _dimensionSelectionAction.getPickerAction().setPointsDataset(inputDataset);
+        _decomposition.reset();
+        _scatterStatistics.reset();
+
+        if (_settingsAction.getLiveUpdate().isChecked())
+            scheduleLiveUpdate();
         });
 }
 
+void PCAPlugin::scheduleLiveUpdate()
+{
+    // restarting the timer debounces a burst of changes
+    _liveUpdateTimer.start(_settingsAction.getLiveUpdateDelay().getValue());
+}
+
 void PCAPlugin::computePCA()
+{
+    // Already waiting for the scheduler
+    if (PCAScheduler::instance().isQueued(_scheduledJob))
+        return;
+
+    // Disable actions until the analysis is done
+    _settingsAction.getStartAnalysisAction().setEnabled(false);
+
+    auto& task = getOutputDataset()->getTask();
+    task.setName("PCA");
+    task.setRunning();
+    task.setDescription("Waiting for other PCA analyses...");
+    task.setProgress(0.0f);
+
+    // An abort while waiting cancels the analysis right when it starts
+    _cancellation.reset();
+
+    // The scheduler starts the analysis once it fits into the memory budget next to the running ones
+    _scheduledJob = PCAScheduler::instance().submit(estimatePeakBytes(), this, [this]() { runPCA(); });
+}
+
+size_t PCAPlugin::estimatePeakBytes()
+{
+    const auto inputDataset = getInputDataset<Points>();
+    const size_t num_points = getNumDataPoints(inputDataset);
+    const size_t num_dims = getEnabledDimensionIndices().size();
+    const math::PCA_ALG alg = getPcaAlgorithm(_settingsAction.getPcaAlgorithmAction().getCurrentIndex());
+    const math::SolverParams solverParams = getSolverParams();
+
+    const bool incremental = _settingsAction.getIncrementalUpdate().isChecked();
+    const bool varianceThreshold = _settingsAction.getVarianceThreshold().isChecked() && !incremental;
+
+    size_t num_comps = _settingsAction.getNumberOfComponents().getValue();
+    if (varianceThreshold)
+        num_comps = num_dims;
+
+    // the extracted data, the output, its copy for the core and the working memory of the decomposition
+    const size_t num_fit_comps = getNumFitComponents(alg, num_comps, num_points, num_dims, solverParams);
+    size_t ioBytes = (num_points * num_dims + 2 * num_points * std::min(num_comps, num_dims)) * sizeof(float);
+
+    // the same choice as in runPCA: the cached statistics of all dimensions are kept, a first run accumulates them from all dimensions
+    const math::FIT_SAMPLE fitSample = incremental ? math::FIT_SAMPLE::ALL_POINTS : getFitSample(num_points);
+    const bool projectParent = canProjectParent(incremental);
+    const bool reuseDecomposition = !incremental && canReuseDecomposition(num_comps);
+    const bool liveUpdate = !reuseDecomposition && canUpdateLive(incremental, varianceThreshold, fitSample, projectParent);
+    if (!incremental && !reuseDecomposition && !projectParent && !liveUpdate && fitSample == math::FIT_SAMPLE::ALL_POINTS && canUseScatterStatistics(alg, num_dims))
+    {
+        const size_t statisticsBytes = getScatterStatisticsBytes(num_points, inputDataset->getNumDimensions(), !_scatterStatistics);
+        return ioBytes + statisticsBytes + math::estimateWorkingBytes<double>(num_dims, num_dims, num_fit_comps, math::PCA_ALG::COV, solverParams);
+    }
+
+    // the extracted full parent and its projection
+    if (projectParent)
+        ioBytes += getNumDataPoints(inputDataset->getFullDataset<Points>()) * (num_dims + std::min(num_comps, num_dims)) * sizeof(float);
+
+    // the live update keeps the extracted data of the previous update
+    if (_settingsAction.getLiveUpdate().isChecked())
+        ioBytes += num_points * num_dims * sizeof(float);
+
+    // the incremental update only decomposes the appended points stacked below the previous components
+    if (incremental)
+        return ioBytes + math::estimateWorkingBytes<float>(num_points, num_dims, num_comps, math::PCA_ALG::SVD, solverParams);
+
+    // only the sample is decomposed, its copy adds to the working memory
+    if (fitSample != math::FIT_SAMPLE::ALL_POINTS)
+    {
+        const size_t num_sample = _settingsAction.getFitSampleSize().getValue();
+        const size_t num_sample_fit_comps = getNumFitComponents(alg, num_comps, num_sample, num_dims, solverParams);
+
+        // the rows of both samples, a stratified sample also labels and orders all points
+        size_t sampleBytes = 2 * num_sample * sizeof(Eigen::Index);
+        if (fitSample == math::FIT_SAMPLE::STRATIFIED)
+            sampleBytes += 2 * num_points * sizeof(uint32_t);
+
+        return ioBytes + sampleBytes + num_sample * num_dims * sizeof(float) + math::estimateWorkingBytes<float>(num_sample, num_dims, num_sample_fit_comps, alg, solverParams);
+    }
+
+    return ioBytes + math::estimateWorkingBytes<float>(num_points, num_dims, num_fit_comps, alg, solverParams);
+}
+
+math::SolverParams PCAPlugin::getSolverParams()
+{
+    math::SolverParams solverParams;
+    solverParams.oversampling = _settingsAction.getOversampling().getValue();
+    solverParams.powerIterations = _settingsAction.getPowerIterations().getValue();
+    solverParams.precision = getPrecision(_settingsAction.getPrecisionAction().getCurrentIndex());
+    solverParams.refinementSteps = _settingsAction.getRefinementSteps().getValue();
+
+    // The number of components is selected by the explained variance, except for the incremental update
+    if (_settingsAction.getVarianceThreshold().isChecked() && !_settingsAction.getIncrementalUpdate().isChecked())
+        solverParams.varianceFraction = _settingsAction.getExplainedVariance().getValue() / 100.0f;
+
+    return solverParams;
+}
+
+void PCAPlugin::runPCA()
 {
     std::cout << "PCA Plugin: Setting up..." << std::endl;
 
@@ -189,31 +924,221 @@ void PCAPlugin::computePCA()
     task.setName("PCA");
     task.setRunning();
     task.setDescription("Computing...");
-
-    // Get data 
-    std::vector<float> data;
-    std::vector<unsigned int> dimensionIndices;
-    getDataFromCore(getInputDataset<Points>(), data, dimensionIndices);
-    size_t num_comps = _settingsAction.getNumberOfComponents().getValue();
+    task.setProgress(getOverallProgress(math::PHASE::EXTRACT, 0.0f));
+    task.setProgressDescription(getPhaseDescription(math::PHASE::EXTRACT));
 
     // Get settings
+    size_t num_comps = _settingsAction.getNumberOfComponents().getValue();
     math::PCA_ALG alg = getPcaAlgorithm(_settingsAction.getPcaAlgorithmAction().getCurrentIndex());
     math::DATA_NORM norm = getDataNorm(_settingsAction.getDataNormAction().getCurrentIndex());
     bool stdOrientation = _settingsAction.getStdAxisOrientation().isChecked();
+    bool incremental = _settingsAction.getIncrementalUpdate().isChecked();
+
+    // The number of components is selected by the explained variance, the number of dimensions is only an upper bound
+    const bool varianceThreshold = _settingsAction.getVarianceThreshold().isChecked() && !incremental;
+    if (varianceThreshold)
+        num_comps = getEnabledDimensionIndices().size();
+
+    // Only extract the appended points if the previous decomposition can be updated
+    // All points are extracted once the aligned projection of the earlier ones may have drifted too far from the exact one
+    const bool updateIncrementally = incremental && canUpdateIncrementally(num_comps, norm);
+    // The projection of the earlier points is missing as well once publishCopy took it over
+    const bool reprojectIncrementally = updateIncrementally && (_incrementalPca->drift() > incrementalDriftTolerance
+        || _incrementalOut.size() != _incrementalPca->numRows() * _incrementalPca->numComponents());
+    const size_t firstPoint = (updateIncrementally && !reprojectIncrementally) ? _incrementalPca->numRows() : 0;
+
+    if (!updateIncrementally)
+    {
+        _incrementalPca.reset();
+        _incrementalOut.clear();
+    }
 
-    // Compute in different thread
-    _pcaWorker = new PCAWorker(std::make_shared<std::vector<float>>(data), dimensionIndices.size(), num_comps, alg, norm, stdOrientation);
+    // The output is replaced, a copy published meanwhile copies it from the core
+    _lastOut.clear();
+
+    // Reuse the last decomposition if only the number of components changed, it is replaced by the one of this run
+    std::shared_ptr<const math::PcaModel<float>> decomposition;
+    if (!incremental && canReuseDecomposition(num_comps))
+        decomposition = _decomposition;
+
+    _decomposition.reset();
+    _decompositionKey = getDecompositionKey();
+
+    // The covariance matrix of any dimension selection is a principal submatrix of the statistics of all dimensions
+    // They are accumulated once, which requires extracting all dimensions
+    const std::vector<unsigned int> selectedDimensions = getEnabledDimensionIndices();
+    const math::FIT_SAMPLE fitSample = incremental ? math::FIT_SAMPLE::ALL_POINTS : getFitSample(getNumDataPoints(getInputDataset<Points>()));
+    const bool projectParent = canProjectParent(incremental);
+    const bool liveUpdate = !decomposition && canUpdateLive(incremental, varianceThreshold, fitSample, projectParent);
+    const bool useScatterStatistics = !incremental && !decomposition && !projectParent && !liveUpdate && fitSample == math::FIT_SAMPLE::ALL_POINTS && canUseScatterStatistics(alg, selectedDimensions.size());
+    const bool extractAllDimensions = useScatterStatistics && !_scatterStatistics;
+
+    // Get data 
+    std::vector<float> data;
+    std::vector<unsigned int> dimensionIndices;
+    getDataFromCore(getInputDataset<Points>(), data, dimensionIndices, firstPoint, extractAllDimensions);
+
+    const size_t num_points = data.size() / std::max<size_t>(dimensionIndices.size(), 1);
+
+    // The first batch fixes the number of components, at most one per point and dimension
+    // A later run with enough points for the requested number fits again, see canUpdateIncrementally
+    if (incremental && !updateIncrementally)
+    {
+        _incrementalPca = std::make_shared<math::IncrementalPCA>(dimensionIndices.size(), std::min({ num_comps, num_points, dimensionIndices.size() }), norm);
+        _incrementalDimensions = _dimensionSelectionAction.getPickerAction().getEnabledDimensions();
+    }
+
+    math::SolverParams solverParams = getSolverParams();
+
+    // The worker polls the token at phase boundaries and inside the kernels, it was reset when the analysis was queued
+    solverParams.cancel = &_cancellation;
+
+    // Compute in different thread, the worker takes over the extracted data
+    _pcaWorker = new PCAWorker(std::make_shared<std::vector<float>>(std::move(data)), dimensionIndices.size(), num_comps, alg, norm, stdOrientation, solverParams);
     _pcaWorker->moveToThread(&_workerThread);
 
+    if (_incrementalPca)
+        _pcaWorker->setIncremental(_incrementalPca, std::move(_incrementalOut), reprojectIncrementally);
+    else
+        _pcaWorker->setDecomposition(decomposition, getNumFitComponents(alg, num_comps, num_points, selectedDimensions.size(), solverParams));
+
+    if (useScatterStatistics)
+        _pcaWorker->setScatterStatistics(_scatterStatistics, selectedDimensions);
+
+    // Update the statistics of the last live update with the changed rows, start over if the dimensions or settings changed since
+    if (liveUpdate && _liveKey != _decompositionKey)
+    {
+        _liveState = {};
+        _liveOut.clear();
+    }
+
+    if (liveUpdate)
+    {
+        _liveKey = _decompositionKey;
+        const double driftTolerance = _settingsAction.getLiveDriftTolerance().getValue() * std::numbers::pi / 180.0;
+        _pcaWorker->setLiveUpdate(_liveState, std::move(_liveOut), driftTolerance);
+    }
+    else
+    {
+        _liveState = {};
+        _liveOut.clear();
+    }
+
+    // Decompose a sample of the points, a second sample checks whether it is large enough
+    // The worker draws the samples, the strata of a stratified sample are extracted here
+    if (fitSample != math::FIT_SAMPLE::ALL_POINTS && !decomposition)
+    {
+        std::vector<uint32_t> labels;
+        if (fitSample == math::FIT_SAMPLE::STRATIFIED)
+            labels = getStrataLabels(Dataset<Clusters>(_settingsAction.getStrataClusters().getCurrentDataset()), getInputDataset<Points>());
+
+        _pcaWorker->setFitSample(fitSample, _settingsAction.getFitSampleSize().getValue(), _settingsAction.getSampleQualityCheck().isChecked(), std::move(labels));
+    }
+
+    // The full parent is extracted here as well and projected in the worker thread, only the subset is fitted
+    // The subset indices are rows of the full data set, whose projection is published in the same row order
+    if (projectParent)
+    {
+        std::vector<float> parentData;
+        std::vector<unsigned int> parentDimensions;
+        getDataFromCore(getInputDataset<Points>()->getFullDataset<Points>(), parentData, parentDimensions, /* firstPoint = */ 0, /* allDimensions = */ false);
+        _pcaWorker->setParentProjection(std::move(parentData));
+    }
+
+    // The plugin keeps the projection for the next update and for publishCopy
+    _pcaWorker->setCopyResults(true);
+
+    // Share the cores with the other running analyses
+    _pcaWorker->setNumThreads(PCAScheduler::instance().numThreadsPerJob());
+
     // setup pca computation 
     connect(this, &PCAPlugin::startPCA, _pcaWorker, &PCAWorker::compute);               
 
+    // show the progress of the computation, queued such that the worker never waits for the GUI
+    connect(_pcaWorker, &PCAWorker::progressChanged, this, [&task](float progress, QString description) {
+        task.setProgress(progress);
+        task.setProgressDescription(description);
+        }, Qt::QueuedConnection);
+
     // get results from PCA
-    connect(_pcaWorker, &PCAWorker::resultReady, this, [&](bool pca_success) {
+    connect(_pcaWorker, &PCAWorker::resultReady, this, [&, varianceThreshold, liveUpdate](bool pca_success) {
         auto [pca_out, num_comps] = _pcaWorker->getResults();
 
-        // Publish pca to core
-        setPCADataInCore(getOutputDataset<Points>(), pca_out, num_comps);
+        // A cancelled computation leaves the previous output in place
+        const bool pca_cancelled = !pca_success && _cancellation.isCancelled();
+
+        task.setProgress(getOverallProgress(math::PHASE::PUBLISH, 0.0f));
+        task.setProgressDescription(getPhaseDescription(math::PHASE::PUBLISH));
+
+        // Publish pca to core, the core takes over the copy that the worker took and the plugin keeps the results
+        // A failed incremental update leaves the last valid output in place
+        if (pca_success)
+            setPCADataInCore(getOutputDataset<Points>(), std::move(_pcaWorker->getResultsCopy()), num_comps);
+        else if (!pca_cancelled && !_incrementalPca)
+            setPCADataInCore(getOutputDataset<Points>(), std::move(pca_out), num_comps);
+
+        // Keep the projection for publishCopy, the incremental and live updates keep theirs below
+        if (pca_success && !_incrementalPca && !liveUpdate)
+            _lastOut = std::move(pca_out);
+
+        // Keep the decomposition for later changes of the number of components, also if only the projection was cancelled
+        if (!_incrementalPca && (pca_success || pca_cancelled))
+            _decomposition = _pcaWorker->getDecomposition();
+
+        // The parent was projected onto the components of the subset
+        if (pca_success && !_pcaWorker->getParentResults().empty())
+            publishParentProjection(std::move(_pcaWorker->getParentResults()), num_comps);
+
+        // The eigenvalues are a by-product of the decomposition, publish them to find the elbow without running again
+        if (!_incrementalPca && pca_success && _pcaWorker->getDecomposition())
+            publishSpectrum(*_pcaWorker->getDecomposition());
+
+        // Report the quality check of the fit sample
+        if (const double angle = _pcaWorker->getSampleSubspaceAngle(); !std::isnan(angle))
+        {
+            const double degrees = angle * 180.0 / std::numbers::pi;
+            _settingsAction.getSampleSubspaceAngle().setString(QString("%1 deg").arg(degrees, 0, 'f', 2));
+        }
+
+        // Show the number of components that was selected by the explained variance, the fixed number of components stays as it is
+        if (varianceThreshold && pca_success)
+            _settingsAction.getSelectedComponents().setString(QString::number(num_comps));
+
+        // Keep the statistics of all dimensions for later changes of the dimension selection
+        if (_pcaWorker->getScatterStatistics())
+            _scatterStatistics = _pcaWorker->getScatterStatistics();
+
+        // Keep the projection for the next incremental update
+        // A failed update left the decomposition and the previous projection unchanged, start over only if they no longer match
+        if (_incrementalPca)
+        {
+            if (pca_success || _incrementalPca->numRows() * _incrementalPca->numComponents() == pca_out.size())
+                _incrementalOut = std::move(pca_out);
+            else
+                _incrementalPca.reset();
+        }
+
+        // Keep the statistics and the projection for the next live update, start over if this update failed or was cancelled
+        if (liveUpdate)
+        {
+            if (pca_success)
+            {
+                _liveState = _pcaWorker->getLiveState();
+                _liveOut = std::move(pca_out);
+            }
+            else
+            {
+                _liveState = {};
+                _liveOut.clear();
+            }
+        }
+
+        // The math layer does not log, its failures and approximate results are reported here
+        const math::SolverStatus& status = _pcaWorker->getStatus();
+        if (!pca_success && !pca_cancelled && !status.error.empty())
+            std::cout << "PCA Plugin: PCA could not be computed: " << status.error << std::endl;
+        else if (pca_success && !status.converged)
+            std::cout << "PCA Plugin: The partial eigensolver did not converge, the components are approximate" << std::endl;
 
         // Flag the analysis task as finished
         if (pca_success == true)
@@ -221,14 +1146,18 @@ void PCAPlugin::computePCA()
         else
         {
             task.setAborted();
-            task.setProgressDescription("Computation failed");
+            task.setProgressDescription(pca_cancelled ? "Computation cancelled" : "Computation failed");
         }
 
         _pcaWorker->deleteLater();
 
-        _workerThread.quit();           // Signal the thread to quit gracefully
-        if (!_workerThread.wait(500))   // Wait for the thread to actually finish
-            _workerThread.terminate();  // Terminate thread after 0.5 seconds
+        // The worker has returned from compute, so the thread finishes as soon as its event loop quits
+        _workerThread.quit();
+        _workerThread.wait();
+
+        // Admit the next queued analysis
+        PCAScheduler::instance().release(_scheduledJob);
+        _scheduledJob = 0;
 
         // Enabled action again
         _settingsAction.getStartAnalysisAction().setEnabled(true);
@@ -237,6 +1166,13 @@ void PCAPlugin::computePCA()
         _settingsAction.getPublishNewDataAction().setEnabled(true);
 
         std::cout << "PCA Plugin: Finished." << std::endl;
+
+        // The input changed during the analysis
+        if (_liveUpdatePending)
+        {
+            _liveUpdatePending = false;
+            scheduleLiveUpdate();
+        }
         });
 
     std::cout << "PCA Plugin: Starting computing PCA transformation with " << num_comps << " components (settings: alg " << alg << ", norm " << norm << ")" << std::endl;
@@ -246,27 +1182,148 @@ void PCAPlugin::computePCA()
     emit startPCA();
 }
 
-void PCAPlugin::getDataFromCore(const mv::Dataset<Points> coreDataset, std::vector<float>& data, std::vector<unsigned int>& dimensionIndices)
+bool PCAPlugin::canUpdateIncrementally(size_t num_comps, math::DATA_NORM norm)
 {
-    // Extract the enabled dimensions from the data
-    std::vector<bool> enabledDimensions = _dimensionSelectionAction.getPickerAction().getEnabledDimensions();
-    const auto numEnabledDimensions = std::count_if(enabledDimensions.begin(), enabledDimensions.end(), [](bool b) { return b; });
+    const auto inputDataset = getInputDataset<Points>();
+
+    // only points that were appended to a full data set can be fitted incrementally, any other change requires a new fit
+    return _incrementalPca
+        && inputDataset->isFull()
+        && inputDataset->getNumPoints() > _incrementalPca->numRows()
+        && _incrementalPca->numComponents() == std::min(num_comps, getEnabledDimensionIndices().size())
+        && _incrementalPca->norm() == norm
+        && _incrementalDimensions == _dimensionSelectionAction.getPickerAction().getEnabledDimensions();
+}
+
+bool PCAPlugin::canReuseDecomposition(size_t num_comps)
+{
+    // the number of components that explain the variance depends on the decomposition
+    return _decomposition
+        && !_settingsAction.getIncrementalUpdate().isChecked()
+        && !_settingsAction.getVarianceThreshold().isChecked()
+        && _decomposition->numComponents() >= num_comps
+        && _decompositionKey == getDecompositionKey();
+}
+
+bool PCAPlugin::canUseScatterStatistics(math::PCA_ALG alg, size_t num_selected_dims)
+{
+    const auto inputDataset = getInputDataset<Points>();
+    const size_t num_dims = inputDataset->getNumDimensions();
+    const size_t num_points = getNumDataPoints(inputDataset);
+
+    // opt-in, the statistics are accumulated in double regardless of the precision setting
+    // wide data uses the smaller Gram matrix, very high-dimensional data would not fit the scatter matrix of all dimensions
+    if (!_settingsAction.getCacheCovariance().isChecked()
+        || alg != math::PCA_ALG::COV
+        || num_points < num_selected_dims
+        || num_dims * num_dims * sizeof(double) > maxScatterStatisticsBytes)
+        return false;
+
+    // accumulating the statistics extracts all dimensions, otherwise the selected dimensions are decomposed as usual
+    return _scatterStatistics || getScatterStatisticsBytes(num_points, num_dims, true) <= PCAScheduler::instance().getMemoryBudget();
+}
+
+DecompositionKey PCAPlugin::getDecompositionKey()
+{
+    return {
+        getInputDataset()->getId(),
+        _dimensionSelectionAction.getPickerAction().getEnabledDimensions(),
+        getDataNorm(_settingsAction.getDataNormAction().getCurrentIndex()),
+        getPcaAlgorithm(_settingsAction.getPcaAlgorithmAction().getCurrentIndex()),
+        getPrecision(_settingsAction.getPrecisionAction().getCurrentIndex()),
+        static_cast<size_t>(_settingsAction.getRefinementSteps().getValue()),
+        static_cast<size_t>(_settingsAction.getOversampling().getValue()),
+        static_cast<size_t>(_settingsAction.getPowerIterations().getValue()),
+        getFitSampleStrategy(_settingsAction.getFitSampleAction().getCurrentIndex()),
+        static_cast<size_t>(_settingsAction.getFitSampleSize().getValue()),
+        _settingsAction.getStrataClusters().getCurrentDataset().isValid() ? _settingsAction.getStrataClusters().getCurrentDataset()->getId() : QString(),
+    };
+}
+
+bool PCAPlugin::canProjectParent(bool incremental)
+{
+    // the incremental update appends points to a full data set, one dimension has nothing to decompose
+    return _settingsAction.getProjectFullParent().isChecked()
+        && !incremental
+        && !getInputDataset<Points>()->isFull()
+        && getEnabledDimensionIndices().size() > 1;
+}
+
+bool PCAPlugin::canUpdateLive(bool incremental, bool varianceThreshold, math::FIT_SAMPLE fitSample, bool projectParent)
+{
+    // the statistics of the covariance algorithm are updated for a fixed number of components, other settings run a full analysis on changes
+    return _settingsAction.getLiveUpdate().isChecked()
+        && !incremental
+        && !varianceThreshold
+        && !projectParent
+        && fitSample == math::FIT_SAMPLE::ALL_POINTS
+        && getPcaAlgorithm(_settingsAction.getPcaAlgorithmAction().getCurrentIndex()) == math::PCA_ALG::COV
+        && getEnabledDimensionIndices().size() > 1;
+}
+
+math::FIT_SAMPLE PCAPlugin::getFitSample(size_t num_points)
+{
+    return math::resolveFitSample(getFitSampleStrategy(_settingsAction.getFitSampleAction().getCurrentIndex()), num_points,
+        static_cast<size_t>(_settingsAction.getFitSampleSize().getValue()), _settingsAction.getStrataClusters().getCurrentDataset().isValid());
+}
 
-    // resize output data
-    data.resize((coreDataset->isFull() ? coreDataset->getNumPoints() : coreDataset->indices.size()) * numEnabledDimensions);
+std::vector<unsigned int> PCAPlugin::getEnabledDimensionIndices()
+{
+    std::vector<bool> enabledDimensions = _dimensionSelectionAction.getPickerAction().getEnabledDimensions();
 
-    // populate dimensionIndices
-    for (uint32_t i = 0; i < coreDataset->getNumDimensions(); i++)
+    std::vector<unsigned int> dimensionIndices;
+    for (uint32_t i = 0; i < enabledDimensions.size(); i++)
         if (enabledDimensions[i])
             dimensionIndices.push_back(i);
 
-    // populate data
-    coreDataset->populateDataForDimensions<std::vector<float>, std::vector<unsigned int>>(data, dimensionIndices);
+    return dimensionIndices;
 }
 
+void PCAPlugin::getDataFromCore(const mv::Dataset<Points> coreDataset, std::vector<float>& data, std::vector<unsigned int>& dimensionIndices, size_t firstPoint, bool allDimensions)
+{
+    // Extract the enabled dimensions from the data
+    if (allDimensions)
+    {
+        dimensionIndices.resize(coreDataset->getNumDimensions());
+        std::iota(dimensionIndices.begin(), dimensionIndices.end(), 0u);
+    }
+    else
+        dimensionIndices = getEnabledDimensionIndices();
+
+    const auto numEnabledDimensions = dimensionIndices.size();
+
+    if (firstPoint == 0)
+    {
+        // resize output data, a subset only extracts its own points
+        data.resize(getNumDataPoints(coreDataset) * numEnabledDimensions);
+
+        // populate data
+        coreDataset->populateDataForDimensions<std::vector<float>, std::vector<unsigned int>>(data, dimensionIndices);
+        return;
+    }
+
+    // only extract the points from firstPoint on
+    std::vector<unsigned int> pointIndices(getNumDataPoints(coreDataset) - firstPoint);
+    std::iota(pointIndices.begin(), pointIndices.end(), static_cast<unsigned int>(firstPoint));
+
+    data.resize(pointIndices.size() * numEnabledDimensions);
+    coreDataset->populateDataForDimensions<std::vector<float>, std::vector<unsigned int>, std::vector<unsigned int>>(data, dimensionIndices, pointIndices);
+}
+
+// The number of points follows from the data, the output of a subset input has only the points of the subset
 void PCAPlugin::setPCADataInCore(mv::Dataset<Points> coreDataset, const std::vector<float>& data, size_t num_components)
 {
-    coreDataset->setData(data.data(), getInputDataset<Points>()->getNumPoints(), num_components);
+    assert(num_components > 0 && data.size() % num_components == 0);
+
+    coreDataset->setData(data.data(), data.size() / num_components, num_components);
+    events().notifyDatasetDataChanged(coreDataset);
+}
+
+void PCAPlugin::setPCADataInCore(mv::Dataset<Points> coreDataset, std::vector<float>&& data, size_t num_components)
+{
+    assert(num_components > 0 && data.size() % num_components == 0);
+
+    coreDataset->setData(std::move(data), num_components);
     events().notifyDatasetDataChanged(coreDataset);
 }
 
@@ -274,16 +1331,75 @@ void PCAPlugin::publishCopy()
 {
     std::cout << "PCA Plugin: Publish a copy of the output dataset." << std::endl;
 
-    // Create new data set
-    auto copyDataset = mv::data().createDataset("Points", "PCA (copy)", getInputDataset());
+    // Both data sets own their values, the new one takes over the projection that the plugin kept of the last analysis
+    // The next incremental or live update then projects all points again instead of only the new or changed ones
+    const auto outputDataset = getOutputDataset<Points>();
+    const size_t num_comps = outputDataset->getNumDimensions();
+    std::vector<float>& kept = _incrementalPca ? _incrementalOut : (_liveOut.empty() ? _lastOut : _liveOut);
 
-    // Get data 
     std::vector<float> data;
-    std::vector<unsigned int> dimensionIndices;
-    getDataFromCore(getOutputDataset<Points>(), data, dimensionIndices);
+    if (num_comps > 0 && kept.size() == static_cast<size_t>(outputDataset->getNumPoints()) * num_comps)
+        data = std::exchange(kept, {});
+    else
+    {
+        // Nothing was kept, e.g. for an output loaded with a project or during an analysis: copy the output in the GUI thread
+        std::vector<unsigned int> dimensionIndices;
+        getDataFromCore(outputDataset, data, dimensionIndices, /* firstPoint = */ 0, /* allDimensions = */ true);
+    }
+
+    auto copyDataset = Dataset<Points>(mv::data().createDataset("Points", "PCA (copy)", getInputDataset()));
+    setPCADataInCore(copyDataset, std::move(data), num_comps);
+}
+
+void PCAPlugin::publishSpectrum(const math::PcaModel<float>& model)
+{
+    const Eigen::VectorXf& eigenvalues = model.eigenvalues();
+    const Eigen::VectorXf ratio = model.explainedVarianceRatio();
+    const Eigen::VectorXf cumulative = model.cumulativeExplainedVarianceRatio();
+    const size_t num_fit_comps = eigenvalues.size();
+
+    if (num_fit_comps == 0)
+        return;
+
+    // One point per component
+    const std::vector<QString> dimensionNames = { "Eigenvalue", "Explained variance ratio", "Cumulative explained variance ratio" };
+    std::vector<float> spectrum(num_fit_comps * dimensionNames.size());
+    for (size_t comp = 0; comp < num_fit_comps; comp++)
+    {
+        spectrum[comp * dimensionNames.size() + 0] = eigenvalues(comp);
+        spectrum[comp * dimensionNames.size() + 1] = ratio(comp);
+        spectrum[comp * dimensionNames.size() + 2] = cumulative(comp);
+    }
+
+    // Reuse the spectrum of a previous run, also after loading a project
+    if (!_spectrumDataset.isValid() && !_spectrumDatasetId.isEmpty())
+        _spectrumDataset = mv::data().getDataset<Points>(_spectrumDatasetId);
+
+    if (!_spectrumDataset.isValid())
+    {
+        _spectrumDataset = Dataset<Points>(mv::data().createDataset("Points", "PCA spectrum", getOutputDataset()));
+        _spectrumDatasetId = _spectrumDataset.getDatasetId();
+    }
+
+    _spectrumDataset->setData(std::move(spectrum), dimensionNames.size());
+    _spectrumDataset->setDimensionNames(dimensionNames);
+    events().notifyDatasetDataChanged(_spectrumDataset);
+}
+
+void PCAPlugin::publishParentProjection(std::vector<float>&& data, size_t num_comps)
+{
+    // Reuse the projection of a previous run, also after loading a project
+    if (!_parentOutputDataset.isValid() && !_parentOutputDatasetId.isEmpty())
+        _parentOutputDataset = mv::data().getDataset<Points>(_parentOutputDatasetId);
+
+    if (!_parentOutputDataset.isValid())
+    {
+        const auto parentDataset = getInputDataset<Points>()->getFullDataset<Points>();
+        _parentOutputDataset = Dataset<Points>(mv::data().createDerivedDataset("PCA (full parent)", parentDataset, getOutputDataset()));
+        _parentOutputDatasetId = _parentOutputDataset.getDatasetId();
+    }
 
-    // Set data
-    setPCADataInCore(copyDataset, data, dimensionIndices.size());
+    setPCADataInCore(_parentOutputDataset, std::move(data), num_comps);
 }
 
 void PCAPlugin::fromVariantMap(const QVariantMap& variantMap)
@@ -295,6 +1411,12 @@ void PCAPlugin::fromVariantMap(const QVariantMap& variantMap)
 
     _settingsAction.fromParentVariantMap(variantMap);
     _dimensionSelectionAction.fromParentVariantMap(variantMap);
+
+    if (variantMap.contains("SpectrumDatasetId"))
+        _spectrumDatasetId = variantMap["SpectrumDatasetId"].toString();
+
+    if (variantMap.contains("ParentOutputDatasetId"))
+        _parentOutputDatasetId = variantMap["ParentOutputDatasetId"].toString();
 }
 
 QVariantMap PCAPlugin::toVariantMap() const
@@ -304,6 +1426,12 @@ QVariantMap PCAPlugin::toVariantMap() const
     _settingsAction.insertIntoVariantMap(variantMap);
     _dimensionSelectionAction.insertIntoVariantMap(variantMap);
 
+    if (!_spectrumDatasetId.isEmpty())
+        variantMap["SpectrumDatasetId"] = _spectrumDatasetId;
+
+    if (!_parentOutputDatasetId.isEmpty())
+        variantMap["ParentOutputDatasetId"] = _parentOutputDatasetId;
+
     return variantMap;
 }
 
@@ -4,54 +4,204 @@
 #include <AnalysisPlugin.h>
 
 #include "DimensionSelectionAction.h"
+#include "PCA.h"
+#include "PcaScheduler.h"
 #include "SettingsAction.h"
 
+#include <chrono>
 #include <cstdint>
+#include <limits>
 #include <memory>
 #include <tuple>
 #include <vector>
 
 #include <QPointer>
+#include <QString>
 #include <QThread>
-
-namespace math {
-    enum class PCA_ALG;
-    enum class DATA_NORM;
-}
+#include <QTimer>
 
 /// ////////// ///
 /// PCA WORKER ///
 /// ////////// ///
 
+/** Kept between live updates, only the rows that changed since are downdated and updated, see PCAWorker::setLiveUpdate */
+struct LiveState
+{
+    std::shared_ptr<const std::vector<float>>           data;           /** Extracted data of the last update */
+    std::shared_ptr<const math::CovarianceAccumulator>  statistics;     /** Statistics of data */
+    std::shared_ptr<const math::PcaModel<float>>        projection;     /** Oriented components that the output was projected with */
+};
+
+// Threading: core data sets are only read and written in the GUI thread, i.e. the data, the strata and the parent rows
+// are extracted before a job is started and the results are published in PCAPlugin::runPCA's resultReady handler
+// The worker runs in its own thread and only gets and returns plain buffers, copies of large buffers are taken there
 class PCAWorker : public QObject
 {
     Q_OBJECT
 
 public:
-    PCAWorker(std::shared_ptr<std::vector<float>> data, size_t num_dims, size_t num_comps, math::PCA_ALG algorithm, math::DATA_NORM norm, bool std_orient);
+    PCAWorker(std::shared_ptr<std::vector<float>> data, size_t num_dims, size_t num_comps, math::PCA_ALG algorithm, math::DATA_NORM norm, bool std_orient, math::SolverParams solver_params);
+
+    /**
+     * Update ipca with the rows in data instead of computing a new PCA, see math::IncrementalPCA
+     * @param ipca Decomposition of the earlier rows, empty if none were fitted yet
+     * @param pca_prev Projection of the earlier rows, is extended by the projection of the rows in data
+     * @param reproject The data contains all rows, the earlier ones are projected again instead of aligned, see math::IncrementalPCA::drift
+     */
+    void setIncremental(std::shared_ptr<math::IncrementalPCA> ipca, std::vector<float>&& pca_prev, bool reproject);
+
+    /**
+     * Project onto an earlier decomposition of the same data and settings instead of computing a new one
+     * @param model Earlier decomposition with at least num_comps components, empty to fit a new one
+     * @param num_fit_comps Number of components of a new fit, at least num_comps
+     */
+    void setDecomposition(std::shared_ptr<const math::PcaModel<float>> model, size_t num_fit_comps);
 
     std::tuple<std::vector<float>&, size_t> getResults() { return { _pca_out, _num_comps }; }
 
+    /** Also copy successful results in the worker thread, such that the core takes over one buffer and the plugin keeps the other */
+    void setCopyResults(bool copyResults) { _copyResults = copyResults; }
+
+    /** Copy of getResults if setCopyResults was called and the computation succeeded, empty otherwise */
+    std::vector<float>& getResultsCopy() { return _pca_out_copy; }
+
+    /** Decomposition that the results were projected onto, empty for incremental updates */
+    std::shared_ptr<const math::PcaModel<float>> getDecomposition() const { return _model; }
+
+    /**
+     * Decompose the principal submatrix of the scatter statistics of all dimensions instead of accumulating the covariance matrix of the data
+     * @param stats Statistics of all dimensions, empty to accumulate them, the data then contains all dimensions
+     * @param dimensions Selected dimensions
+     */
+    void setScatterStatistics(std::shared_ptr<const math::CovarianceAccumulator> stats, const std::vector<unsigned int>& dimensions);
+
+    /** Statistics of all dimensions if setScatterStatistics was called */
+    std::shared_ptr<const math::CovarianceAccumulator> getScatterStatistics() const { return _scatterStatistics; }
+
+    /** Failure reason and convergence of the computation, see math::SolverStatus */
+    const math::SolverStatus& getStatus() const { return _status; }
+
+    /** Number of OpenMP threads of the computation, 0 for the OpenMP default */
+    void setNumThreads(int num_threads);
+
+    /**
+     * Decompose only a sample of the rows, all rows are projected, the sample is drawn in the worker thread
+     * @param strategy Uniform or stratified sample, a stratified sample without a stratum for each row is drawn uniformly
+     * @param sampleSize Number of rows of the sample
+     * @param qualityCheck Also decompose a second sample and compare its components with those of the first
+     * @param labels Stratum of each row for a stratified sample, empty if the strata of the rows are unknown
+     */
+    void setFitSample(math::FIT_SAMPLE strategy, size_t sampleSize, bool qualityCheck, std::vector<uint32_t>&& labels);
+
+    /** Largest principal angle in radians between the components of both samples, NaN if there was no second sample */
+    double getSampleSubspaceAngle() const { return _sampleSubspaceAngle; }
+
+    /**
+     * Update the statistics of the previous live update with the rows that changed since, instead of accumulating them again
+     * The output is projected with the previous components as long as they drift less than the tolerance, otherwise all rows are projected
+     * @param previous State of the previous update with the same dimensions and settings, its members are empty for the first update
+     * @param pca_prev Projection of the previous update
+     * @param driftTolerance Largest angle in radians between the previous and the updated components, also bounds the shift of the mean relative to the standard deviation
+     */
+    void setLiveUpdate(LiveState previous, std::vector<float>&& pca_prev, double driftTolerance);
+
+    /** State for the next live update if setLiveUpdate was called */
+    LiveState getLiveState() const { return _live; }
+
+    /**
+     * Also project the full parent of a subset onto the components that are fitted on the subset, chunk by chunk
+     * @param parentData Row-major rows of the parent with the dimensions of the data, released once they are projected
+     */
+    void setParentProjection(std::vector<float>&& parentData);
+
+    /** Projection of the full parent if setParentProjection was called, with the components of getResults */
+    std::vector<float>& getParentResults() { return _parent_out; }
+
 signals:
     void resultReady(bool pca_success);
 
+    /**
+     * Throttled progress of the computation, emitted from the worker thread
+     * @param progress Overall progress in [0, 1]
+     * @param description Current phase
+     */
+    void progressChanged(float progress, QString description);
+
 public slots:
     void compute();
 
+private:
+    bool computeFromModel();
+    bool computeFromScatterStatistics();
+    bool updateIncremental();
+    bool updateLive();
+
+    /** Project the subset data and all parent rows with the same, oriented components */
+    bool projectWithParent(const Eigen::Map<const math::RowMajorMatrixXf>& data, Eigen::Map<math::RowMajorMatrixXf>& pca_out);
+
+    /** Forwards progress from math::pca, at most once per progress interval unless the phase changes or completes */
+    void reportProgress(math::PHASE phase, float fraction);
+
 private:
     std::shared_ptr<std::vector<float>> _data;
     size_t _num_dims;
     size_t _num_comps;
     bool _std_orient;
     std::vector<float> _pca_out;
+    std::vector<float> _pca_out_copy;
+    bool _copyResults = false;
     math::PCA_ALG _algorithm;
     math::DATA_NORM _norm;
+    math::SolverParams _solver_params;
+    math::SolverStatus _status;
+    std::shared_ptr<math::IncrementalPCA> _ipca;
+    bool _reproject = false;
+    std::shared_ptr<const math::PcaModel<float>> _model;
+    size_t _num_fit_comps = 0;
+    bool _useScatterStatistics = false;
+    std::shared_ptr<const math::CovarianceAccumulator> _scatterStatistics;
+    std::vector<unsigned int> _scatterDimensions;
+    int _num_threads = 0;
+    math::FIT_SAMPLE _fitSampleStrategy = math::FIT_SAMPLE::ALL_POINTS;
+    size_t _fitSampleSize = 0;
+    bool _sampleQualityCheck = false;
+    std::vector<uint32_t> _labels;
+    std::vector<Eigen::Index> _fitSample;
+    std::vector<Eigen::Index> _checkSample;
+    double _sampleSubspaceAngle = std::numeric_limits<double>::quiet_NaN();
+    std::vector<float> _parent_data;
+    std::vector<float> _parent_out;
+    bool _useLiveUpdate = false;
+    LiveState _live;
+    double _driftTolerance = 0.0;
+
+    std::chrono::steady_clock::time_point _lastProgressTime;    /** Time of the last emitted progressChanged */
+    math::PHASE _lastProgressPhase = math::PHASE::EXTRACT;      /** Phase of the last emitted progressChanged */
 };
 
 
 /// ////////// ///
 /// PCA PLUGIN ///
 /// ////////// ///
+
+/** Input and settings of a decomposition, a cached decomposition can be reused for another number of components if all of them match */
+struct DecompositionKey
+{
+    QString             datasetId;
+    std::vector<bool>   enabledDimensions;
+    math::DATA_NORM     norm;
+    math::PCA_ALG       algorithm;
+    math::PRECISION     precision;
+    size_t              refinementSteps;
+    size_t              oversampling;
+    size_t              powerIterations;
+    math::FIT_SAMPLE    fitSample;
+    size_t              fitSampleSize;
+    QString             strataDatasetId;
+
+    bool operator==(const DecompositionKey& other) const = default;
+};
+
 class PCAPlugin : public mv::plugin::AnalysisPlugin
 {
 Q_OBJECT
@@ -64,8 +214,8 @@ public:
      */
     PCAPlugin(const mv::plugin::PluginFactory* factory);
 
-    /** Destructor */
-    ~PCAPlugin() override = default;
+    /** Destructor, cancels a running computation and waits for the worker thread */
+    ~PCAPlugin() override;
 
     /* This function is called by the core after the analysis plugin has been created, sets up init data */
     void init() override;
@@ -89,9 +239,24 @@ public: // Serialization
 
 private:
     void computePCA();
-    void getDataFromCore(const mv::Dataset<Points> coreDataset, std::vector<float>& data, std::vector<unsigned int>& indices);
+    void runPCA();
+    size_t estimatePeakBytes();
+    math::SolverParams getSolverParams();
+    bool canUpdateIncrementally(size_t num_comps, math::DATA_NORM norm);
+    bool canReuseDecomposition(size_t num_comps);
+    bool canUseScatterStatistics(math::PCA_ALG alg, size_t num_selected_dims);
+    DecompositionKey getDecompositionKey();
+    std::vector<unsigned int> getEnabledDimensionIndices();
+    math::FIT_SAMPLE getFitSample(size_t num_points);
+    bool canProjectParent(bool incremental);
+    bool canUpdateLive(bool incremental, bool varianceThreshold, math::FIT_SAMPLE fitSample, bool projectParent);
+    void scheduleLiveUpdate();
+    void getDataFromCore(const mv::Dataset<Points> coreDataset, std::vector<float>& data, std::vector<unsigned int>& indices, size_t firstPoint = 0, bool allDimensions = false);
     void setPCADataInCore(mv::Dataset<Points> coreDataset, const std::vector<float>& data, const size_t num_components);
+    void setPCADataInCore(mv::Dataset<Points> coreDataset, std::vector<float>&& data, const size_t num_components);
     void publishCopy();
+    void publishSpectrum(const math::PcaModel<float>& model);
+    void publishParentProjection(std::vector<float>&& data, size_t num_comps);
 
 private:
     SettingsAction              _settingsAction;            /** General PCA settings */
@@ -99,6 +264,30 @@ private:
 
     QPointer<PCAWorker>         _pcaWorker;                 /** Worker that computes PCA in another thread */
     QThread                     _workerThread;              /** Thread for PCA computation */
+    math::CancellationToken     _cancellation;              /** Cancels the running PCA computation, set when the task is aborted */
+    PCAScheduler::JobId         _scheduledJob = 0;          /** Queued or running analysis in the PCAScheduler, 0 if none */
+
+    std::shared_ptr<math::IncrementalPCA>   _incrementalPca;        /** Decomposition that is updated with appended points */
+    std::vector<bool>                       _incrementalDimensions; /** Enabled input dimensions of _incrementalPca */
+    std::vector<float>                      _incrementalOut;        /** Projection of all points fitted by _incrementalPca */
+
+    std::shared_ptr<const math::PcaModel<float>>    _decomposition;     /** Last full decomposition, changing only the number of components re-projects onto it */
+    DecompositionKey                                _decompositionKey;  /** Input and settings of _decomposition */
+
+    std::shared_ptr<const math::CovarianceAccumulator> _scatterStatistics;  /** Mean, min, max and scatter matrix of all input dimensions */
+
+    mv::Dataset<Points>         _spectrumDataset;           /** Eigenvalues and explained variance ratios of the last decomposition, one point per component */
+    QString                     _spectrumDatasetId;         /** Id of _spectrumDataset, kept in the project */
+
+    mv::Dataset<Points>         _parentOutputDataset;       /** Projection of the full parent of a subset input onto the components of the subset */
+    QString                     _parentOutputDatasetId;     /** Id of _parentOutputDataset, kept in the project */
+
+    QTimer                      _liveUpdateTimer;           /** Debounces changes of the input in live mode */
+    bool                        _liveUpdatePending = false; /** The input changed while an analysis was running */
+    LiveState                   _liveState;                 /** Statistics and projection of the last live update */
+    DecompositionKey            _liveKey;                   /** Input and settings of _liveState */
+    std::vector<float>          _liveOut;                   /** Projection of the last live update */
+    std::vector<float>          _lastOut;                   /** Projection of the last other analysis, taken over by publishCopy */
 };
 
 /// ////////////// ///
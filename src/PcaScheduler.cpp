@@ -0,0 +1,97 @@
+#include "PcaScheduler.h"
+
+#include <QMetaObject>
+#include <QThread>
+
+#include <algorithm>
+
+// Defaults, both can be changed in the settings of any PCA plugin
+static constexpr size_t defaultMemoryBudget = size_t{ 4 } << 30;
+static constexpr size_t defaultMaxConcurrentJobs = 2;
+
+PCAScheduler& PCAScheduler::instance()
+{
+    static PCAScheduler scheduler;
+    return scheduler;
+}
+
+PCAScheduler::PCAScheduler() :
+    QObject(),
+    _memoryBudget(defaultMemoryBudget),
+    _maxConcurrentJobs(defaultMaxConcurrentJobs)
+{
+}
+
+PCAScheduler::JobId PCAScheduler::submit(size_t estimatedBytes, QObject* context, std::function<void()> start)
+{
+    const JobId id = _nextId++;
+    _queue.push_back({ id, estimatedBytes, context, std::move(start) });
+
+    admit();
+
+    return id;
+}
+
+void PCAScheduler::release(JobId id)
+{
+    if (auto running = _running.find(id); running != _running.end())
+    {
+        _usedBytes -= running->second;
+        _running.erase(running);
+    }
+    else
+        std::erase_if(_queue, [id](const Job& job) { return job.id == id; });
+
+    admit();
+}
+
+bool PCAScheduler::isQueued(JobId id) const
+{
+    return std::any_of(_queue.begin(), _queue.end(), [id](const Job& job) { return job.id == id; });
+}
+
+int PCAScheduler::numThreadsPerJob() const
+{
+    // the cores are split evenly between the admitted jobs, a job that runs on its own uses all of them
+    return std::max(1, QThread::idealThreadCount() / static_cast<int>(std::max<size_t>(_running.size(), 1)));
+}
+
+void PCAScheduler::setMemoryBudget(size_t bytes)
+{
+    _memoryBudget = bytes;
+    admit();
+}
+
+void PCAScheduler::setMaxConcurrentJobs(size_t num_jobs)
+{
+    _maxConcurrentJobs = std::max<size_t>(num_jobs, 1);
+    admit();
+}
+
+void PCAScheduler::admit()
+{
+    // in submission order, such that large jobs are not starved by smaller ones
+    while (!_queue.empty() && _running.size() < _maxConcurrentJobs)
+    {
+        Job& job = _queue.front();
+
+        // a job that exceeds the whole budget runs on its own
+        const bool fits = _usedBytes + job.estimatedBytes <= _memoryBudget;
+        if (!fits && !_running.empty())
+            break;
+
+        _running[job.id] = job.estimatedBytes;
+        _usedBytes += job.estimatedBytes;
+
+        // queued, such that a job never starts from within the release of another one
+        if (job.context)
+            QMetaObject::invokeMethod(job.context, std::move(job.start), Qt::QueuedConnection);
+        else
+        {
+            _usedBytes -= job.estimatedBytes;
+            _running.erase(job.id);
+        }
+
+        _queue.pop_front();
+    }
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+
+#include <QObject>
+#include <QPointer>
+
+/// ///////////// ///
+/// PCA SCHEDULER ///
+/// ///////////// ///
+
+/**
+ * Queue of the PCA computations of all plugin instances
+ *
+ * Each plugin runs its computation in its own thread, each of which uses OpenMP.
+ * The scheduler bounds the number of computations that run at the same time and only admits
+ * a computation if its estimated peak memory fits into the memory budget next to the running ones.
+ * Jobs are admitted in submission order, a job that exceeds the whole budget runs on its own.
+ *
+ * All functions must be called from the GUI thread.
+ */
+class PCAScheduler : public QObject
+{
+    Q_OBJECT
+
+public:
+    using JobId = std::uint64_t;
+
+    /** Scheduler shared by all plugin instances */
+    static PCAScheduler& instance();
+
+    /**
+     * Queue a computation
+     * @param estimatedBytes Estimated peak memory of the computation
+     * @param context Object that starts the computation, the start is dropped if it is destroyed
+     * @param start Called in the thread of context once the job is admitted
+     * @return Id to release the job with
+     */
+    JobId submit(size_t estimatedBytes, QObject* context, std::function<void()> start);
+
+    /**
+     * Remove a queued job or release the memory of a running one, admits queued jobs
+     * @param id Id of the job, unknown ids are ignored
+     */
+    void release(JobId id);
+
+    /** Whether the job waits for admission */
+    bool isQueued(JobId id) const;
+
+    /** Number of OpenMP threads of a computation that starts now, the cores are split between the admitted computations including it */
+    int numThreadsPerJob() const;
+
+    size_t getMemoryBudget() const { return _memoryBudget; }
+    void setMemoryBudget(size_t bytes);
+
+    size_t getMaxConcurrentJobs() const { return _maxConcurrentJobs; }
+    void setMaxConcurrentJobs(size_t num_jobs);
+
+private:
+    PCAScheduler();
+
+    /** Start queued jobs in order while they fit */
+    void admit();
+
+private:
+    struct Job
+    {
+        JobId                   id;
+        size_t                  estimatedBytes;
+        QPointer<QObject>       context;
+        std::function<void()>   start;
+    };
+
+    std::deque<Job>             _queue;             /** Jobs that wait for admission */
+    std::map<JobId, size_t>     _running;           /** Estimated peak memory of the admitted jobs */
+    size_t                      _usedBytes = 0;     /** Sum of _running */
+    size_t                      _memoryBudget;      /** Memory that all running jobs may use together */
+    size_t                      _maxConcurrentJobs; /** Bound of the number of running jobs */
+    JobId                       _nextId = 1;
+};
@@ -5,7 +5,27 @@ SettingsAction::SettingsAction(QObject* parent) :
     _pcaAlgorithmAction(this, "PCA alg"),
     _dataNormAction(this, "Data norm"),
     _numberOfComponents(this, "Number of PCA components"),
+    _varianceThreshold(this, "Select by explained variance"),
+    _explainedVariance(this, "Explained variance [%]"),
+    _selectedComponents(this, "Selected components"),
+    _oversampling(this, "Oversampling"),
+    _powerIterations(this, "Power iterations"),
+    _precisionAction(this, "Precision"),
+    _refinementSteps(this, "Refinement steps"),
+    _cacheCovariance(this, "Cache covariance"),
     _stdAxisOrientation(this, "Std. axis orientation"),
+    _incrementalUpdate(this, "Incremental update"),
+    _fitSampleAction(this, "Fit sample"),
+    _fitSampleSize(this, "Fit sample size"),
+    _strataClusters(this, "Strata"),
+    _sampleQualityCheck(this, "Sample quality check"),
+    _sampleSubspaceAngle(this, "Sample subspace angle"),
+    _projectFullParent(this, "Project full parent"),
+    _liveUpdate(this, "Live update"),
+    _liveUpdateDelay(this, "Live update delay [ms]"),
+    _liveDriftTolerance(this, "Live drift tolerance [deg]"),
+    _memoryBudget(this, "Memory budget [MB]"),
+    _maxConcurrentAnalyses(this, "Concurrent analyses"),
     _startAnalysisAction(this, "Start analysis"),
     _publishNewDataAction(this, "Copy to new data set")
 {
@@ -15,21 +35,136 @@ SettingsAction::SettingsAction(QObject* parent) :
     _pcaAlgorithmAction.setToolTip("Type of PCA algorithm");
     _dataNormAction.setToolTip("Type data normalization");
     _numberOfComponents.setToolTip("Number of PCA components to be used");
+    _varianceThreshold.setToolTip("Use the fewest components that explain the given share of the variance instead of a fixed number");
+    _explainedVariance.setToolTip("Share of the total variance that the selected components explain");
+    _selectedComponents.setToolTip("Number of components that the last analysis selected by the explained variance");
+    _oversampling.setToolTip("Randomized SVD: number of random samples in addition to the number of components");
+    _powerIterations.setToolTip("Randomized SVD: number of power iterations, more iterations increase accuracy");
+    _precisionAction.setToolTip("COV: Mixed keeps the data in float but accumulates and decomposes the covariance matrix in double");
+    _refinementSteps.setToolTip("COV: number of subspace iteration steps that refine the eigenvectors");
+    _cacheCovariance.setToolTip("COV: accumulate the covariance matrix of all dimensions once in double precision, changing the dimension selection then only decomposes its submatrix");
     _stdAxisOrientation.setToolTip("Enforce standardized axis orientation");
+    _incrementalUpdate.setToolTip("Only fit points that were appended to the input since the last analysis, incremental SVD regardless of the PCA alg");
+    _fitSampleAction.setToolTip("Decompose all points or only a sample of them, all points are projected onto the components");
+    _fitSampleSize.setToolTip("Number of points of the fit sample");
+    _strataClusters.setToolTip("Stratified sample: clusters of the input points, each cluster is sampled in proportion to its size");
+    _sampleQualityCheck.setToolTip("Also decompose a second sample and report the largest angle between the components of both samples");
+    _sampleSubspaceAngle.setToolTip("Largest principal angle between the components of two samples, small angles indicate that the sample is large enough");
+    _projectFullParent.setToolTip("Subset input: fit only the subset and also project all points of its full parent onto the components");
+    _liveUpdate.setToolTip("Update the output when the input data changes, COV only updates the covariance matrix with the changed points");
+    _liveUpdateDelay.setToolTip("Time without further changes of the input before the update starts");
+    _liveDriftTolerance.setToolTip("Live update: only changed points are projected while the components drift less than this angle, otherwise all points");
+    _memoryBudget.setToolTip("Estimated memory that all running PCA analyses may use together, further analyses wait until running ones finish");
+    _maxConcurrentAnalyses.setToolTip("Number of PCA analyses of all data sets that may run at the same time, the cores are split evenly between them");
     _startAnalysisAction.setToolTip("Start the analysis");
     _publishNewDataAction.setToolTip("Published a copy of the output");
 
     _publishNewDataAction.setEnabled(false); // only enable once an analysis is done
 
-    _pcaAlgorithmAction.initialize(QStringList({ "COV", "SVD" }), "COV");
+    _pcaAlgorithmAction.initialize(QStringList({ "COV", "SVD", "Randomized SVD" }), "COV");
     _dataNormAction.initialize(QStringList({ "None", "Mean Norm", "Min-Max Norm"}), "None");
     _stdAxisOrientation.setChecked(true);
+    _incrementalUpdate.setChecked(false);
     _numberOfComponents.initialize(1, 2, 2);    // default: use 2 PCA components, max is set data-dependent in PcaPlugin.cpp 
+    _varianceThreshold.setChecked(false);
+    _explainedVariance.initialize(1.0f, 100.0f, 95.0f, 1);
+    _selectedComponents.setEnabled(false);      // only displays the result
+    _oversampling.initialize(0, 100, 10);
+    _powerIterations.initialize(0, 20, 4);
+    _precisionAction.initialize(QStringList({ "Single", "Mixed" }), "Single");
+    _refinementSteps.initialize(0, 10, 0);
+    _cacheCovariance.setChecked(false);
+    _memoryBudget.initialize(256, 1 << 20, 4096);
+    _maxConcurrentAnalyses.initialize(1, 16, 2);
+    _liveUpdate.setChecked(false);
+    _liveUpdateDelay.initialize(0, 10'000, 250);
+    _liveDriftTolerance.initialize(0.0f, 45.0f, 1.0f, 2);
+    _fitSampleAction.initialize(QStringList({ "All points", "Uniform sample", "Stratified sample" }), "All points");
+    _fitSampleSize.initialize(1'000, 100'000'000, 200'000);
+    _sampleQualityCheck.setChecked(false);
+    _sampleSubspaceAngle.setEnabled(false);     // only displays the result
+    _projectFullParent.setChecked(false);       // only enabled for subset inputs in PcaPlugin.cpp
+
+    // only the randomized SVD uses oversampling and power iterations, only COV the precision settings
+    // the incremental update always uses an incremental SVD
+    const auto updateAlgorithmSettings = [this]() -> void {
+        const bool isIncremental = _incrementalUpdate.isChecked();
+        const bool isRandomized = _pcaAlgorithmAction.getCurrentText() == "Randomized SVD";
+        const bool isCov = _pcaAlgorithmAction.getCurrentText() == "COV";
+        _pcaAlgorithmAction.setEnabled(!isIncremental);
+        _oversampling.setEnabled(isRandomized && !isIncremental);
+        _powerIterations.setEnabled(isRandomized && !isIncremental);
+        _precisionAction.setEnabled(isCov && !isIncremental);
+        _refinementSteps.setEnabled(isCov && !isIncremental);
+        _cacheCovariance.setEnabled(isCov && !isIncremental);
+    };
+
+    // the incremental update keeps a fixed number of components
+    const auto updateComponentSettings = [this]() -> void {
+        const bool isIncremental = _incrementalUpdate.isChecked();
+        const bool isVarianceThreshold = _varianceThreshold.isChecked() && !isIncremental;
+        _varianceThreshold.setEnabled(!isIncremental);
+        _explainedVariance.setEnabled(isVarianceThreshold);
+        _numberOfComponents.setEnabled(!isVarianceThreshold);
+    };
+
+    // the incremental update fits all appended points
+    const auto updateSampleSettings = [this]() -> void {
+        const bool isIncremental = _incrementalUpdate.isChecked();
+        const bool isSampled = _fitSampleAction.getCurrentIndex() != 0 && !isIncremental;
+        _fitSampleAction.setEnabled(!isIncremental);
+        _fitSampleSize.setEnabled(isSampled);
+        _strataClusters.setEnabled(isSampled && _fitSampleAction.getCurrentText() == "Stratified sample");
+        _sampleQualityCheck.setEnabled(isSampled);
+    };
+
+    // only the covariance matrix of COV is updated live, the other settings recompute
+    const auto updateLiveSettings = [this]() -> void {
+        const bool isLive = _liveUpdate.isChecked();
+        const bool isCov = _pcaAlgorithmAction.getCurrentText() == "COV";
+        _liveUpdateDelay.setEnabled(isLive);
+        _liveDriftTolerance.setEnabled(isLive && isCov && !_incrementalUpdate.isChecked());
+    };
+
+    updateAlgorithmSettings();
+    updateComponentSettings();
+    updateSampleSettings();
+    updateLiveSettings();
+
+    connect(&_pcaAlgorithmAction, &OptionAction::currentIndexChanged, this, updateAlgorithmSettings);
+    connect(&_pcaAlgorithmAction, &OptionAction::currentIndexChanged, this, updateLiveSettings);
+    connect(&_incrementalUpdate, &ToggleAction::toggled, this, updateAlgorithmSettings);
+    connect(&_incrementalUpdate, &ToggleAction::toggled, this, updateComponentSettings);
+    connect(&_incrementalUpdate, &ToggleAction::toggled, this, updateSampleSettings);
+    connect(&_incrementalUpdate, &ToggleAction::toggled, this, updateLiveSettings);
+    connect(&_varianceThreshold, &ToggleAction::toggled, this, updateComponentSettings);
+    connect(&_fitSampleAction, &OptionAction::currentIndexChanged, this, updateSampleSettings);
+    connect(&_liveUpdate, &ToggleAction::toggled, this, updateLiveSettings);
 
     addAction(&_pcaAlgorithmAction);
     addAction(&_dataNormAction);
     addAction(&_numberOfComponents);
+    addAction(&_varianceThreshold);
+    addAction(&_explainedVariance);
+    addAction(&_selectedComponents);
+    addAction(&_oversampling);
+    addAction(&_powerIterations);
+    addAction(&_precisionAction);
+    addAction(&_refinementSteps);
+    addAction(&_cacheCovariance);
     addAction(&_stdAxisOrientation);
+    addAction(&_incrementalUpdate);
+    addAction(&_fitSampleAction);
+    addAction(&_fitSampleSize);
+    addAction(&_strataClusters);
+    addAction(&_sampleQualityCheck);
+    addAction(&_sampleSubspaceAngle);
+    addAction(&_projectFullParent);
+    addAction(&_liveUpdate);
+    addAction(&_liveUpdateDelay);
+    addAction(&_liveDriftTolerance);
+    addAction(&_memoryBudget);
+    addAction(&_maxConcurrentAnalyses);
     addAction(&_startAnalysisAction);
     addAction(&_publishNewDataAction);
 }
@@ -41,7 +176,25 @@ void SettingsAction::fromVariantMap(const QVariantMap& variantMap)
     _pcaAlgorithmAction.fromParentVariantMap(variantMap);
     _dataNormAction.fromParentVariantMap(variantMap);
     _numberOfComponents.fromParentVariantMap(variantMap);
+    _varianceThreshold.fromParentVariantMap(variantMap);
+    _explainedVariance.fromParentVariantMap(variantMap);
+    _oversampling.fromParentVariantMap(variantMap);
+    _powerIterations.fromParentVariantMap(variantMap);
+    _precisionAction.fromParentVariantMap(variantMap);
+    _refinementSteps.fromParentVariantMap(variantMap);
+    _cacheCovariance.fromParentVariantMap(variantMap);
     _stdAxisOrientation.fromParentVariantMap(variantMap);
+    _incrementalUpdate.fromParentVariantMap(variantMap);
+    _fitSampleAction.fromParentVariantMap(variantMap);
+    _fitSampleSize.fromParentVariantMap(variantMap);
+    _strataClusters.fromParentVariantMap(variantMap);
+    _sampleQualityCheck.fromParentVariantMap(variantMap);
+    _projectFullParent.fromParentVariantMap(variantMap);
+    _liveUpdate.fromParentVariantMap(variantMap);
+    _liveUpdateDelay.fromParentVariantMap(variantMap);
+    _liveDriftTolerance.fromParentVariantMap(variantMap);
+    _memoryBudget.fromParentVariantMap(variantMap);
+    _maxConcurrentAnalyses.fromParentVariantMap(variantMap);
     _startAnalysisAction.fromParentVariantMap(variantMap);
     _publishNewDataAction.fromParentVariantMap(variantMap);
 }
@@ -53,7 +206,25 @@ QVariantMap SettingsAction::toVariantMap() const
     _pcaAlgorithmAction.insertIntoVariantMap(variantMap);
     _dataNormAction.insertIntoVariantMap(variantMap);
     _numberOfComponents.insertIntoVariantMap(variantMap);
+    _varianceThreshold.insertIntoVariantMap(variantMap);
+    _explainedVariance.insertIntoVariantMap(variantMap);
+    _oversampling.insertIntoVariantMap(variantMap);
+    _powerIterations.insertIntoVariantMap(variantMap);
+    _precisionAction.insertIntoVariantMap(variantMap);
+    _refinementSteps.insertIntoVariantMap(variantMap);
+    _cacheCovariance.insertIntoVariantMap(variantMap);
     _stdAxisOrientation.insertIntoVariantMap(variantMap);
+    _incrementalUpdate.insertIntoVariantMap(variantMap);
+    _fitSampleAction.insertIntoVariantMap(variantMap);
+    _fitSampleSize.insertIntoVariantMap(variantMap);
+    _strataClusters.insertIntoVariantMap(variantMap);
+    _sampleQualityCheck.insertIntoVariantMap(variantMap);
+    _projectFullParent.insertIntoVariantMap(variantMap);
+    _liveUpdate.insertIntoVariantMap(variantMap);
+    _liveUpdateDelay.insertIntoVariantMap(variantMap);
+    _liveDriftTolerance.insertIntoVariantMap(variantMap);
+    _memoryBudget.insertIntoVariantMap(variantMap);
+    _maxConcurrentAnalyses.insertIntoVariantMap(variantMap);
     _startAnalysisAction.insertIntoVariantMap(variantMap);
     _publishNewDataAction.insertIntoVariantMap(variantMap);
 
@@ -1,8 +1,11 @@
 #pragma once
 
+#include "actions/DatasetPickerAction.h"
+#include "actions/DecimalAction.h"
 #include "actions/GroupAction.h"
 #include "actions/IntegralAction.h"
 #include "actions/OptionAction.h"
+#include "actions/StringAction.h"
 #include "actions/ToggleAction.h"
 #include "actions/TriggerAction.h"
 
@@ -28,7 +31,27 @@ public: // Action getters
     OptionAction& getPcaAlgorithmAction() { return _pcaAlgorithmAction; }
     OptionAction& getDataNormAction() { return _dataNormAction; }
     IntegralAction& getNumberOfComponents() { return _numberOfComponents; }
+    ToggleAction& getVarianceThreshold() { return _varianceThreshold; }
+    DecimalAction& getExplainedVariance() { return _explainedVariance; }
+    StringAction& getSelectedComponents() { return _selectedComponents; }
+    IntegralAction& getOversampling() { return _oversampling; }
+    IntegralAction& getPowerIterations() { return _powerIterations; }
+    OptionAction& getPrecisionAction() { return _precisionAction; }
+    IntegralAction& getRefinementSteps() { return _refinementSteps; }
+    ToggleAction& getCacheCovariance() { return _cacheCovariance; }
     ToggleAction& getStdAxisOrientation() { return _stdAxisOrientation; }
+    ToggleAction& getIncrementalUpdate() { return _incrementalUpdate; }
+    OptionAction& getFitSampleAction() { return _fitSampleAction; }
+    IntegralAction& getFitSampleSize() { return _fitSampleSize; }
+    DatasetPickerAction& getStrataClusters() { return _strataClusters; }
+    ToggleAction& getSampleQualityCheck() { return _sampleQualityCheck; }
+    StringAction& getSampleSubspaceAngle() { return _sampleSubspaceAngle; }
+    ToggleAction& getProjectFullParent() { return _projectFullParent; }
+    ToggleAction& getLiveUpdate() { return _liveUpdate; }
+    IntegralAction& getLiveUpdateDelay() { return _liveUpdateDelay; }
+    DecimalAction& getLiveDriftTolerance() { return _liveDriftTolerance; }
+    IntegralAction& getMemoryBudget() { return _memoryBudget; }
+    IntegralAction& getMaxConcurrentAnalyses() { return _maxConcurrentAnalyses; }
     TriggerAction& getStartAnalysisAction() { return _startAnalysisAction; }
     TriggerAction& getPublishNewDataAction() { return _publishNewDataAction; }
 
@@ -50,7 +73,27 @@ public:
     OptionAction    _pcaAlgorithmAction;            /** PCA algorithm action */
     OptionAction    _dataNormAction;                /** data normalization action */
     IntegralAction  _numberOfComponents;            /** Number of components action */
+    ToggleAction    _varianceThreshold;             /** Select the number of components by the explained variance */
+    DecimalAction   _explainedVariance;             /** Explained variance in percent that the selected components must reach */
+    StringAction    _selectedComponents;            /** Number of components that the explained variance selected */
+    IntegralAction  _oversampling;                  /** Oversampling of the randomized SVD */
+    IntegralAction  _powerIterations;               /** Power iterations of the randomized SVD */
+    OptionAction    _precisionAction;               /** Precision of the covariance accumulation */
+    IntegralAction  _refinementSteps;               /** Refinement steps of the covariance eigenvectors */
+    ToggleAction    _cacheCovariance;               /** Keep the covariance matrix of all dimensions for later dimension selections */
     ToggleAction    _stdAxisOrientation;            /** Enforce standardized axis orientation */
+    ToggleAction    _incrementalUpdate;             /** Update the PCA with appended points instead of recomputing */
+    OptionAction    _fitSampleAction;               /** Fit on all points or on a uniform or stratified sample */
+    IntegralAction  _fitSampleSize;                 /** Number of points of the fit sample */
+    DatasetPickerAction _strataClusters;            /** Clusters of the input that define the strata of the stratified sample */
+    ToggleAction    _sampleQualityCheck;            /** Compare the components of the sample with those of a second sample */
+    StringAction    _sampleSubspaceAngle;           /** Largest principal angle between the components of both samples */
+    ToggleAction    _projectFullParent;             /** Fit a subset input and also project the full parent */
+    ToggleAction    _liveUpdate;                    /** Recompute when the input data changes */
+    IntegralAction  _liveUpdateDelay;               /** Debounce time in ms of changes of the input */
+    DecimalAction   _liveDriftTolerance;            /** Angle in degrees that the components may drift before all points are projected again */
+    IntegralAction  _memoryBudget;                  /** Memory budget in MB of all running PCA analyses, see PCAScheduler */
+    IntegralAction  _maxConcurrentAnalyses;         /** Number of PCA analyses that may run at the same time, each uses a share of the cores */
     TriggerAction   _startAnalysisAction;           /** Start computation */
     TriggerAction   _publishNewDataAction;          /** Publish new data set, one that is not derived */
 };
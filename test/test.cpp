@@ -1,9 +1,11 @@
 #include <catch2/catch_test_macros.hpp>	// for info on testing see https://github.com/catchorg/Catch2/blob/devel/docs/tutorial.md#test-cases-and-sections
+#include <catch2/benchmark/catch_benchmark.hpp>	// see https://github.com/catchorg/Catch2/blob/devel/docs/benchmarks.md
 #include <nlohmann/json.hpp>
 
 #include <filesystem>
 #include <fstream>
 #include <iostream>
+#include <random>
 #include <source_location>
 #include <string>
 #include <vector>
@@ -551,3 +553,1228 @@ TEST_CASE("Iris data normalization", "[MeanNorm][MinMaxNorm]") {
 
 
 }
+
+/// Randomized SVD
+/// Test the randomized truncated SVD against the full SVD on the iris data and on a synthetic low-rank data set
+TEST_CASE("Randomized SVD", "[PCA][RANDOMIZED][SVD]") {
+
+	SECTION("Iris") {
+		printLine("Iris data: randomized SVD, MinMaxNorm");
+
+		std::vector<float> data_in;
+		fs::path fileNameIris = dataDir / "iris_data.bin";
+		bool readFileSuccess = readBinaryToStdVector(fileNameIris.string(), data_in);
+		REQUIRE(readFileSuccess == true);
+
+		std::vector<float> data_transformed_reference;
+		fs::path fileNameTransNormMinMax2 = dataDir / "iris_trans_norm_minmax_2.bin";
+		readFileSuccess = readBinaryToStdVector(fileNameTransNormMinMax2.string(), data_transformed_reference);
+		REQUIRE(readFileSuccess == true);
+
+		const size_t num_dims = 4;
+		size_t num_comp = 2;
+
+		std::vector<float> transRandomized;
+		math::pca(data_in, num_dims, transRandomized, num_comp, math::PCA_ALG::RANDOMIZED, math::DATA_NORM::MINMAX);
+
+		REQUIRE(compStdAndStdMatrixAppr(transRandomized, data_transformed_reference, num_comp));
+	}
+
+	SECTION("Low rank") {
+		printLine("Synthetic low-rank data: randomized SVD");
+
+		const Eigen::Index num_pts = 500;
+		const Eigen::Index num_dim = 60;
+		const size_t num_comp = 3;
+
+		// rank 5 data with decaying spectrum plus small noise
+		std::mt19937 gen(42);
+		std::normal_distribution<float> dist(0.0f, 1.0f);
+		Eigen::MatrixXf left(num_pts, 5), right(5, num_dim), noise(num_pts, num_dim);
+		for (Eigen::Index i = 0; i < left.size(); i++) left.data()[i] = dist(gen);
+		for (Eigen::Index i = 0; i < right.size(); i++) right.data()[i] = dist(gen);
+		for (Eigen::Index i = 0; i < noise.size(); i++) noise.data()[i] = 0.01f * dist(gen);
+		const Eigen::Vector<float, 5> scales{ 10.0f, 6.0f, 3.0f, 1.0f, 0.5f };
+
+		Eigen::MatrixXf data = math::colwiseZeroMean(left * scales.asDiagonal() * right + noise);
+
+		Eigen::MatrixXf transSVD = math::pcaTransform(data, math::pcaSVD(data, num_comp));
+		Eigen::MatrixXf transRandomized = math::pcaTransform(data, math::pcaRandomizedSVD(data, num_comp));
+
+		REQUIRE(compEigAndEigMatrixAppr(math::standardOrientation(transSVD), math::standardOrientation(transRandomized), 0.01f));
+	}
+
+}
+
+/// Partial eigensolver
+/// Test the subspace iteration for the top eigenpairs against the full eigendecomposition of the covariance matrix
+TEST_CASE("Partial eigensolver", "[PCA][COV]") {
+
+	const Eigen::Index num_pts = 400;
+	const Eigen::Index num_dim = 150;
+	const size_t num_comp = 3;
+
+	// data with a decaying spectrum
+	std::mt19937 gen(7);
+	std::normal_distribution<float> dist(0.0f, 1.0f);
+	Eigen::MatrixXf data(num_pts, num_dim);
+	for (Eigen::Index col = 0; col < num_dim; col++)
+		for (Eigen::Index row = 0; row < num_pts; row++)
+			data(row, col) = dist(gen) * 10.0f / (1.0f + col);
+	data = math::colwiseZeroMean(data);
+
+	Eigen::MatrixXf covMat = data.transpose() * data;
+
+	SECTION("Eigenpairs") {
+		printLine("Synthetic data: top eigenpairs");
+
+		math::SolverParams params;
+		Eigen::MatrixXf eigenvectors;
+		Eigen::VectorXf eigenvalues;
+		math::topEigenpairs(covMat, num_comp, eigenvectors, eigenvalues, params);
+
+		Eigen::SelfAdjointEigenSolver<Eigen::MatrixXf> es(covMat);
+		Eigen::VectorXf eigenvalues_reference = es.eigenvalues().reverse().head(num_comp);
+		Eigen::MatrixXf eigenvectors_reference = es.eigenvectors().rowwise().reverse().leftCols(num_comp);
+
+		REQUIRE(((eigenvalues - eigenvalues_reference).cwiseAbs().array() <= 1e-3f * eigenvalues_reference[0]).all());
+		REQUIRE(compEigAndEigMatrixAppr(eigenvectors, eigenvectors_reference, 0.001f));
+	}
+
+	SECTION("Convergence status") {
+		printLine("Synthetic data: top eigenpairs convergence status");
+
+		math::SolverStatus status;
+		math::SolverParams params;
+		params.status = &status;
+
+		Eigen::MatrixXf eigenvectors;
+		Eigen::VectorXf eigenvalues;
+		REQUIRE(math::topEigenpairs(covMat, num_comp, eigenvectors, eigenvalues, params));
+		REQUIRE(status.converged);
+
+		// one iteration does not reach the tolerance, the approximate eigenpairs are still returned
+		params.maxIterations = 1;
+		params.tolerance = 1e-7f;
+		REQUIRE_FALSE(math::topEigenpairs(covMat, num_comp, eigenvectors, eigenvalues, params));
+		REQUIRE_FALSE(status.converged);
+		REQUIRE(eigenvectors.cols() == static_cast<Eigen::Index>(num_comp));
+
+		// failures are reported through the status as well
+		math::CovarianceAccumulator accumulator(num_dim);
+		const Eigen::RowVectorXf firstRow = data.row(0);
+		accumulator.addChunk(firstRow.data(), 1);
+		size_t num_comp_acc = num_comp;
+		REQUIRE_FALSE(accumulator.finalize(num_comp_acc, math::DATA_NORM::NONE, params));
+		REQUIRE_FALSE(status.error.empty());
+	}
+
+	SECTION("Automatic selection") {
+		printLine("Synthetic data: COV with partial eigensolver");
+
+		math::SolverParams params;
+		REQUIRE(math::usePartialEigensolver(num_dim, num_comp, params));
+
+		Eigen::MatrixXf transPartial = math::pcaTransform(data, math::pcaCovMat(data, num_comp, params));
+
+		params.partialEigenFraction = 0.0f;
+		REQUIRE_FALSE(math::usePartialEigensolver(num_dim, num_comp, params));
+
+		Eigen::MatrixXf transFull = math::pcaTransform(data, math::pcaCovMat(data, num_comp, params));
+
+		REQUIRE(compEigAndEigMatrixAppr(math::standardOrientation(transPartial), math::standardOrientation(transFull), 0.01f));
+	}
+
+}
+
+/// Gram matrix
+/// Test the dual formulation for data with fewer points than dimensions against the SVD
+TEST_CASE("Gram matrix wide data", "[PCA][COV][SVD]") {
+
+	printLine("Synthetic wide data: Gram matrix");
+
+	const Eigen::Index num_pts = 40;
+	const Eigen::Index num_dim = 300;
+	size_t num_comp = 4;
+
+	std::mt19937 gen(3);
+	std::normal_distribution<float> dist(0.0f, 1.0f);
+	Eigen::MatrixXf data(num_pts, num_dim);
+	for (Eigen::Index col = 0; col < num_dim; col++)
+		for (Eigen::Index row = 0; row < num_pts; row++)
+			data(row, col) = dist(gen) * (1.0f + 5.0f * (col % 7 == 0));
+	data = math::colwiseZeroMean(data);
+
+	Eigen::MatrixXf principal_components_SVD = math::pcaSVD(data, num_comp);
+	Eigen::MatrixXf transSVD = math::pcaTransform(data, principal_components_SVD);
+
+	Eigen::MatrixXf transGram;
+	Eigen::MatrixXf principal_components_Gram = math::pcaGramMat(data, num_comp, transGram);
+
+	REQUIRE(compEigAndEigMatrixAppr(math::standardOrientation(transSVD), math::standardOrientation(transGram), 0.01f));
+	REQUIRE(compEigAndEigMatrixAppr(math::standardOrientation(math::pcaTransform(data, principal_components_Gram)), math::standardOrientation(transGram), 0.01f));
+
+	// single step picks the Gram matrix for wide data
+	std::vector<float> data_std = math::convertEigenMatrixToStdVector(data);
+	std::vector<float> transCOV;
+	math::pca(data_std, num_dim, transCOV, num_comp, math::PCA_ALG::COV, math::DATA_NORM::NONE);
+	REQUIRE(compStdAndStdMatrixAppr(transCOV, math::convertEigenMatrixToStdVector(transSVD), num_comp, 0.01f));
+
+	// the fitted model keeps the projection of the Gram matrix, projecting the fitted data again yields the same values
+	math::PcaModel<float> model;
+	model.fit(data, num_comp, math::PCA_ALG::COV, math::DATA_NORM::NONE);
+	REQUIRE(model.fittedProjection().rows() == num_pts);
+	REQUIRE(model.fittedProjection().isApprox(Eigen::MatrixXf(model.transform(data)), 1e-3f));
+
+	Eigen::MatrixXf transFitted(num_pts, 2);
+	Eigen::MatrixXf transProjected(num_pts, 2);
+	REQUIRE(math::pcaIntoFitted(model, data, transFitted));
+	REQUIRE(math::pcaInto(model, data, transProjected));
+	REQUIRE(transFitted.isApprox(transProjected, 1e-3f));
+
+	// tall data uses the covariance matrix, which keeps no projection
+	math::PcaModel<float> modelTall;
+	modelTall.fit(Eigen::MatrixXf(data.transpose()), num_comp, math::PCA_ALG::COV, math::DATA_NORM::NONE);
+	REQUIRE(modelTall.fittedProjection().size() == 0);
+
+}
+
+/// Covariance accumulator
+/// Test the chunked one-pass accumulation with the iris data against the single step reference
+TEST_CASE("Covariance accumulator", "[PCA][COV][MeanNorm][MinMaxNorm]") {
+
+	std::vector<float> data_in;
+	fs::path fileNameDataIris = dataDir / "iris_data.bin";
+	bool readFileSuccess = readBinaryToStdVector(fileNameDataIris.string(), data_in);
+	REQUIRE(readFileSuccess == true);
+
+	std::vector<float> data_transformed_reference;
+	fs::path fileNameTransNormMean2 = dataDir / "iris_trans_norm_mean_2.bin";
+	readFileSuccess = readBinaryToStdVector(fileNameTransNormMean2.string(), data_transformed_reference);
+	REQUIRE(readFileSuccess == true);
+
+	const size_t num_dims = 4;
+	const size_t num_points = data_in.size() / num_dims;
+	const size_t chunk_size = 17;	// does not divide the number of points
+
+	auto accumulateAndTransform = [&](math::DATA_NORM norm) -> std::vector<float> {
+		size_t num_comp = 2;
+
+		math::CovarianceAccumulator acc(num_dims);
+		for (size_t row = 0; row < num_points; row += chunk_size)
+			acc.addChunk(data_in.data() + row * num_dims, std::min(chunk_size, num_points - row));
+
+		REQUIRE(acc.numRows() == num_points);
+		REQUIRE(acc.finalize(num_comp, norm));
+
+		std::vector<float> trans(num_points * num_comp);
+		for (size_t row = 0; row < num_points; row += chunk_size)
+			acc.transformChunk(data_in.data() + row * num_dims, std::min(chunk_size, num_points - row), trans.data() + row * num_comp);
+
+		return trans;
+	};
+
+	SECTION("Statistics") {
+		printLine("Iris data: accumulated statistics");
+
+		math::CovarianceAccumulator acc(num_dims);
+		for (size_t row = 0; row < num_points; row += chunk_size)
+			acc.addChunk(data_in.data() + row * num_dims, std::min(chunk_size, num_points - row));
+
+		Eigen::MatrixXf data = math::convertStdVectorToEigenMatrix(data_in, num_dims);
+		Eigen::MatrixXd centered = math::colwiseZeroMean(data).cast<double>();
+		Eigen::MatrixXd covMat_reference = centered.transpose() * centered / static_cast<double>(num_points - 1);
+
+		REQUIRE(acc.mean().cast<float>().isApprox(data.colwise().mean().transpose(), 1e-5f));
+		REQUIRE(acc.minValues() == data.colwise().minCoeff().transpose());
+		REQUIRE(acc.maxValues() == data.colwise().maxCoeff().transpose());
+		REQUIRE(acc.covariance().isApprox(covMat_reference, 1e-5));
+	}
+
+	SECTION("Mean Norm") {
+		printLine("Iris data: accumulated, Mean Norm");
+		REQUIRE(compStdAndStdMatrixAppr(accumulateAndTransform(math::DATA_NORM::MEAN), data_transformed_reference, 2));
+	}
+
+	SECTION("MinMax Norm") {
+		// both normalizations differ only by a shift which is removed by the centering
+		printLine("Iris data: accumulated, MinMax Norm");
+		REQUIRE(compStdAndStdMatrixAppr(accumulateAndTransform(math::DATA_NORM::MINMAX), data_transformed_reference, 2));
+	}
+
+	SECTION("Dimension subset") {
+		// the statistics of a dimension subset are taken from those of all dimensions
+		printLine("Iris data: accumulated, dimension subset");
+
+		const std::vector<unsigned int> dims = { 0, 2, 3 };
+		size_t num_comp = 2;
+
+		math::CovarianceAccumulator acc(num_dims);
+		acc.addChunk(data_in.data(), num_points);
+
+		math::CovarianceAccumulator accSubset = acc.subset(dims);
+		REQUIRE(accSubset.numDims() == dims.size());
+		REQUIRE(accSubset.numRows() == num_points);
+		REQUIRE(accSubset.finalize(num_comp, math::DATA_NORM::MINMAX));
+
+		std::vector<float> data_subset(num_points * dims.size());
+		for (size_t row = 0; row < num_points; row++)
+			for (size_t col = 0; col < dims.size(); col++)
+				data_subset[row * dims.size() + col] = data_in[row * num_dims + dims[col]];
+
+		std::vector<float> trans_reference;
+		size_t num_comp_ref = num_comp;
+		REQUIRE(math::pca(data_subset, dims.size(), trans_reference, num_comp_ref, math::PCA_ALG::COV, math::DATA_NORM::MINMAX));
+
+		// the projection of the selected columns of all dimensions is the same as that of the extracted subset
+		const math::PcaModel<float> model = accSubset.model();
+		Eigen::Map<const math::RowMajorMatrixXf> data(data_in.data(), num_points, num_dims);
+		math::RowMajorMatrixXf trans(num_points, num_comp);
+		REQUIRE(math::pcaInto(model, data(Eigen::placeholders::all, dims), trans));
+
+		REQUIRE(compStdAndStdMatrixAppr(std::vector<float>(trans.data(), trans.data() + trans.size()), trans_reference, 2));
+	}
+
+}
+
+/// Incremental PCA
+/// Test the batch-wise update of the decomposition with the iris data against the single step reference
+TEST_CASE("Incremental PCA", "[PCA][INCREMENTAL][MeanNorm]") {
+
+	std::vector<float> data_in;
+	fs::path fileNameDataIris = dataDir / "iris_data.bin";
+	bool readFileSuccess = readBinaryToStdVector(fileNameDataIris.string(), data_in);
+	REQUIRE(readFileSuccess == true);
+
+	const size_t num_dims = 4;
+	const size_t num_points = data_in.size() / num_dims;
+	const size_t num_comp = 2;
+
+	// shuffle the points so that every batch samples the whole data set
+	std::vector<float> data_shuffled(data_in.size());
+	{
+		std::vector<size_t> order(num_points);
+		std::iota(order.begin(), order.end(), 0);
+		std::shuffle(order.begin(), order.end(), std::mt19937(11));
+		for (size_t row = 0; row < num_points; row++)
+			std::copy_n(data_in.begin() + order[row] * num_dims, num_dims, data_shuffled.begin() + row * num_dims);
+	}
+
+	SECTION("All components in batches") {
+		printLine("Iris data: incremental, all components");
+
+		// with all components the incremental update is exact
+		math::IncrementalPCA ipca(num_dims, num_dims, math::DATA_NORM::NONE);
+		const size_t batch_size = 30;
+		std::vector<float> transIncremental(num_points * num_dims);
+
+		for (size_t row = 0; row < num_points; row += batch_size)
+		{
+			REQUIRE(ipca.partialFit(data_shuffled.data() + row * num_dims, batch_size));
+			ipca.alignPrevious(transIncremental.data(), row);
+			ipca.transform(data_shuffled.data() + row * num_dims, batch_size, transIncremental.data() + row * num_dims);
+		}
+
+		REQUIRE(ipca.numRows() == num_points);
+
+		size_t num_comp_ref = num_dims;
+		std::vector<float> transSVD;
+		math::pca(data_shuffled, num_dims, transSVD, num_comp_ref, math::PCA_ALG::SVD, math::DATA_NORM::NONE);
+
+		REQUIRE(compStdAndStdMatrixAppr(transIncremental, transSVD, num_dims, 0.001f));
+	}
+
+	SECTION("Two components, two batches") {
+		printLine("Iris data: incremental, two components");
+
+		// truncating to two components after the first batch discards some information of that batch
+		math::IncrementalPCA ipca(num_dims, num_comp, math::DATA_NORM::NONE);
+		const size_t num_first = 100;
+		std::vector<float> transIncremental(num_points * num_comp);
+
+		REQUIRE(ipca.partialFit(data_shuffled.data(), num_first));
+		REQUIRE(ipca.drift() == 0.0);
+		ipca.transform(data_shuffled.data(), num_first, transIncremental.data());
+		REQUIRE(ipca.partialFit(data_shuffled.data() + num_first * num_dims, num_points - num_first));
+		ipca.alignPrevious(transIncremental.data(), num_first);
+		ipca.transform(data_shuffled.data() + num_first * num_dims, num_points - num_first, transIncremental.data() + num_first * num_comp);
+
+		std::vector<float> transIncrementalFull(num_points * num_comp);
+		ipca.transform(data_shuffled.data(), num_points, transIncrementalFull.data());
+
+		// the error of each aligned row is bounded by the drift times its distance to the mean of the first batch
+		REQUIRE(ipca.drift() > 0.0);
+		{
+			Eigen::Map<const Eigen::Matrix<float, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>> first(data_shuffled.data(), num_first, num_dims);
+			const Eigen::RowVectorXf firstMean = first.colwise().mean();
+
+			for (size_t row = 0; row < num_first; row++)
+			{
+				float error = 0;
+				for (size_t comp = 0; comp < num_comp; comp++)
+					error += std::pow(transIncremental[row * num_comp + comp] - transIncrementalFull[row * num_comp + comp], 2.0f);
+
+				REQUIRE(std::sqrt(error) <= ipca.drift() * (first.row(row) - firstMean).norm() + 1e-4f);
+			}
+		}
+
+		// projecting all rows again starts a new drift bound
+		ipca.resetDrift();
+		REQUIRE(ipca.drift() == 0.0);
+
+		size_t num_comp_ref = num_comp;
+		std::vector<float> transSVD;
+		math::pca(data_shuffled, num_dims, transSVD, num_comp_ref, math::PCA_ALG::SVD, math::DATA_NORM::NONE);
+
+		// re-projecting all points matches the batch PCA closely, aligning the earlier projection approximately
+		REQUIRE(compStdAndStdMatrixAppr(transIncrementalFull, transSVD, num_comp, 0.1f));
+		REQUIRE(compStdAndStdMatrixAppr(transIncremental, transSVD, num_comp, 0.2f));
+	}
+
+	SECTION("First batch smaller than the number of components") {
+		printLine("Iris data: incremental, small first batch");
+
+		// a too small first batch is rejected instead of lowering the number of components for good
+		const size_t num_comp_all = 3;
+		math::IncrementalPCA ipca(num_dims, num_comp_all, math::DATA_NORM::NONE);
+		math::SolverStatus status;
+		REQUIRE_FALSE(ipca.partialFit(data_shuffled.data(), num_comp_all - 1, &status));
+		REQUIRE_FALSE(status.error.empty());
+		REQUIRE(ipca.numRows() == 0);
+		REQUIRE(ipca.numComponents() == num_comp_all);
+
+		// later batches may be smaller than the number of components
+		REQUIRE(ipca.partialFit(data_shuffled.data(), 10));
+		REQUIRE(ipca.partialFit(data_shuffled.data() + 10 * num_dims, 1));
+		REQUIRE(ipca.numRows() == 11);
+		REQUIRE(ipca.numComponents() == num_comp_all);
+		REQUIRE(ipca.components().cols() == static_cast<Eigen::Index>(num_comp_all));
+
+		// more components than dimensions are clamped right away
+		REQUIRE(math::IncrementalPCA(num_dims, num_dims + 2).numComponents() == num_dims);
+	}
+
+}
+
+/// Row-major input
+/// Test that the span overload reads the data in place and matches the reference for a part of the iris data
+TEST_CASE("Row-major span input", "[PCA][COV][SVD][MinMaxNorm]") {
+
+	std::vector<float> data_in;
+	fs::path fileNameDataIris = dataDir / "iris_data.bin";
+	bool readFileSuccess = readBinaryToStdVector(fileNameDataIris.string(), data_in);
+	REQUIRE(readFileSuccess == true);
+
+	const size_t num_dims = 4;
+	const size_t num_points = 100;
+
+	// reference: copy of the first num_points points
+	const std::vector<float> data_part(data_in.begin(), data_in.begin() + num_points * num_dims);
+	const std::span<const float> data_span(data_in.data(), num_points * num_dims);
+
+	for (const auto alg : { math::PCA_ALG::COV, math::PCA_ALG::SVD })
+	{
+		size_t num_comp_span = 2, num_comp_vec = 2;
+		std::vector<float> transSpan, transVec;
+
+		REQUIRE(math::pca(data_span, num_dims, transSpan, num_comp_span, alg, math::DATA_NORM::MINMAX));
+		REQUIRE(math::pca(data_part, num_dims, transVec, num_comp_vec, alg, math::DATA_NORM::MINMAX));
+
+		REQUIRE(transSpan.size() == num_points * 2);
+		REQUIRE(compStdAndStdMatrixAppr(transSpan, transVec, 2));
+	}
+
+}
+
+/// Fused normalization
+/// Test the chunked statistics pass and the fused normalization and centering against plain Eigen expressions
+TEST_CASE("Fused normalization and centering", "[PCA][MeanNorm][MinMaxNorm]") {
+
+	// more rows than fit into a single chunk
+	const Eigen::Index num_rows = 50'000;
+	const Eigen::Index num_dims = 3;
+
+	std::mt19937 gen(3);
+	std::uniform_real_distribution<float> dist(-5.0f, 20.0f);
+	math::RowMajorMatrixXf data(num_rows, num_dims);
+	for (Eigen::Index i = 0; i < data.size(); i++)
+		data.data()[i] = dist(gen);
+
+	// constant column is not scaled
+	data.col(2).setConstant(1.5f);
+
+	REQUIRE(num_rows > math::rowChunkSize(num_dims));
+
+	const math::ColumnStatistics stats = math::columnStatistics(data);
+	REQUIRE(compEigAndEigMatrixAppr(stats.minVals, data.colwise().minCoeff().transpose()));
+	REQUIRE(compEigAndEigMatrixAppr(stats.maxVals, data.colwise().maxCoeff().transpose()));
+	REQUIRE(compEigAndEigMatrixAppr(stats.mean.cast<float>(), data.cast<double>().colwise().mean().transpose().cast<float>()));
+
+	for (const auto norm : { math::DATA_NORM::NONE, math::DATA_NORM::MEAN, math::DATA_NORM::MINMAX })
+	{
+		Eigen::MatrixXf normed;
+		math::normalizeAndCenter(data, norm, normed);
+
+		Eigen::RowVectorXf scale = Eigen::RowVectorXf::Ones(num_dims);
+		if (norm != math::DATA_NORM::NONE)
+			scale.head(2) = data.leftCols(2).colwise().maxCoeff() - data.leftCols(2).colwise().minCoeff();
+
+		const Eigen::MatrixXf reference = (data.rowwise() - data.colwise().mean()).array().rowwise() / scale.array();
+		REQUIRE(compEigAndEigMatrixAppr(normed, reference, 0.001f));
+	}
+
+}
+
+/// Scatter kernel
+/// Test the blocked, multithreaded scatter matrix against a plain matrix product
+TEST_CASE("Blocked scatter matrix", "[PCA][COV]") {
+
+	// more rows than fit into a single chunk
+	const Eigen::Index num_rows = 20'000;
+	const Eigen::Index num_dims = 7;
+
+	std::mt19937 gen(5);
+	std::normal_distribution<float> dist(3.0f, 2.0f);
+	math::RowMajorMatrixXf data(num_rows, num_dims);
+	for (Eigen::Index i = 0; i < data.size(); i++)
+		data.data()[i] = dist(gen);
+
+	const math::ColumnStatistics stats = math::columnStatistics(data);
+	const Eigen::VectorXf mean = stats.mean.cast<float>();
+	const Eigen::VectorXf normFacs = math::normalizationFactors(stats.minVals, stats.maxVals, math::DATA_NORM::MEAN);
+
+	const Eigen::MatrixXf normed = (data.rowwise() - mean.transpose()) * normFacs.cwiseInverse().asDiagonal();
+	const Eigen::MatrixXf reference = normed.transpose() * normed;
+
+	SECTION("Normalize and center on the fly") {
+		const Eigen::MatrixXf scatter = math::scatterMatrix(data, mean, normFacs);
+		REQUIRE(compEigAndEigMatrixAppr(scatter.triangularView<Eigen::Lower>().toDenseMatrix(), reference.triangularView<Eigen::Lower>().toDenseMatrix(), 0.001f));
+	}
+
+	SECTION("Centered data") {
+		const Eigen::MatrixXf scatter = math::scatterMatrix(normed);
+		REQUIRE(compEigAndEigMatrixAppr(scatter.triangularView<Eigen::Lower>().toDenseMatrix(), reference.triangularView<Eigen::Lower>().toDenseMatrix(), 0.001f));
+	}
+
+	SECTION("Projection") {
+		const Eigen::MatrixXf components = math::pcaCovMat(normed, 3);
+		REQUIRE(compEigAndEigMatrixAppr(math::pcaTransform(data, mean, normFacs, components), math::pcaTransform(normed, components), 0.001f));
+	}
+
+}
+
+/// Data marshalling
+/// Test the tiled transposes between row-major std vectors and column-major Eigen matrices for sizes that are not multiples of the tile size
+TEST_CASE("Tiled conversion", "[CONVERSION]") {
+
+	for (const auto& [num_rows, num_dims] : { std::pair<size_t, size_t>{ 1'001, 3 }, { 77, 45 }, { 5, 1 } })
+	{
+		std::vector<float> data(num_rows * num_dims);
+		std::iota(data.begin(), data.end(), 0.0f);
+
+		const Eigen::MatrixXf mat = math::convertStdVectorToEigenMatrix(data, num_dims);
+		REQUIRE(mat == math::mapRowMajor(data, num_dims));
+		REQUIRE(math::convertEigenMatrixToStdVector(mat) == data);
+	}
+
+}
+
+/// Run with: PcaTests "[benchmark]"
+/// Conversion between the ManiVault row-major layout and Eigen's column-major layout for a large data set
+TEST_CASE("Tiled conversion benchmark", "[.][benchmark][CONVERSION]") {
+
+	const size_t num_rows = 2'000'000;
+	const size_t num_dims = 20;
+
+	std::vector<float> data(num_rows * num_dims);
+	std::iota(data.begin(), data.end(), 0.0f);
+
+	const Eigen::MatrixXf mat = math::convertStdVectorToEigenMatrix(data, num_dims);
+
+	BENCHMARK("std::vector to Eigen::MatrixXf") {
+		return math::convertStdVectorToEigenMatrix(data, num_dims);
+	};
+
+	BENCHMARK("Eigen::MatrixXf to std::vector") {
+		return math::convertEigenMatrixToStdVector(mat);
+	};
+
+	BENCHMARK("Reference: Eigen assignment from row-major map") {
+		return Eigen::MatrixXf(math::mapRowMajor(data, num_dims));
+	};
+
+}
+
+/// Output buffer
+/// Test that pcaInto writes the projection directly into a caller-provided buffer, for all algorithms
+TEST_CASE("Projection into output buffer", "[PCA][COV][SVD][RANDOMIZED][MinMaxNorm]") {
+
+	std::vector<float> data_in;
+	fs::path fileNameDataIris = dataDir / "iris_data.bin";
+	bool readFileSuccess = readBinaryToStdVector(fileNameDataIris.string(), data_in);
+	REQUIRE(readFileSuccess == true);
+
+	const size_t num_dims = 4;
+	const size_t num_points = data_in.size() / num_dims;
+	const size_t num_comp = 2;
+
+	for (const auto alg : { math::PCA_ALG::COV, math::PCA_ALG::SVD, math::PCA_ALG::RANDOMIZED })
+	{
+		// the output is a view into a larger buffer, values outside of it must not be touched
+		std::vector<float> buffer(num_points * num_comp + 2, -1.0f);
+		const std::span<float> out(buffer.data() + 1, num_points * num_comp);
+
+		REQUIRE(math::pcaInto(data_in, num_dims, out, num_comp, alg, math::DATA_NORM::MINMAX));
+		REQUIRE(buffer.front() == -1.0f);
+		REQUIRE(buffer.back() == -1.0f);
+
+		size_t num_comp_ref = num_comp;
+		std::vector<float> trans;
+		REQUIRE(math::pca(data_in, num_dims, trans, num_comp_ref, alg, math::DATA_NORM::MINMAX));
+		REQUIRE(compStdAndStdMatrixAppr(trans, std::vector<float>(out.begin(), out.end()), num_comp));
+	}
+
+	SECTION("Number of components is clamped") {
+		size_t num_comp_large = 10;
+		std::vector<float> trans;
+		REQUIRE(math::pca(data_in, num_dims, trans, num_comp_large, math::PCA_ALG::COV, math::DATA_NORM::NONE));
+		REQUIRE(num_comp_large == num_dims);
+		REQUIRE(trans.size() == num_points * num_dims);
+	}
+
+}
+
+/// Mixed precision
+/// Test the double accumulation of the covariance matrix for float data with a wide range of variances against a double reference
+TEST_CASE("Mixed precision covariance", "[PCA][COV][PRECISION]") {
+
+	const Eigen::Index num_rows = 200'000;
+	const Eigen::Index num_dims = 6;
+
+	// standard deviations from 1 down to 1e-3, all dimensions offset from the origin
+	std::mt19937 gen(7);
+	std::normal_distribution<float> dist(0.0f, 1.0f);
+	math::RowMajorMatrixXf data(num_rows, num_dims);
+	for (Eigen::Index row = 0; row < num_rows; row++)
+		for (Eigen::Index col = 0; col < num_dims; col++)
+			data(row, col) = 100.0f + std::pow(0.25f, static_cast<float>(col)) * dist(gen);
+
+	// reference in double
+	const Eigen::MatrixXd dataD = data.cast<double>();
+	const Eigen::MatrixXd centeredD = dataD.rowwise() - dataD.colwise().mean();
+	Eigen::SelfAdjointEigenSolver<Eigen::MatrixXd> es(centeredD.transpose() * centeredD);
+	const Eigen::MatrixXd reference = es.eigenvectors().rowwise().reverse();
+
+	const math::ColumnStatistics stats = math::columnStatistics(data);
+	const Eigen::VectorXf ones = Eigen::VectorXf::Ones(num_dims);
+
+	math::SolverParams params;
+
+	// components are unique up to their sign
+	auto maxDeviation = [&reference](const Eigen::MatrixXd& components) {
+		return (components.cwiseAbs() - reference.leftCols(components.cols()).cwiseAbs()).cwiseAbs().maxCoeff();
+	};
+
+	SECTION("Double accumulation") {
+		// relative deviation of the lower triangle from the scatter matrix of the double reference
+		const Eigen::MatrixXd scatterReference = centeredD.transpose() * centeredD;
+		auto scatterDeviation = [&scatterReference](const Eigen::MatrixXd& scatter) {
+			const Eigen::MatrixXd difference = scatter.triangularView<Eigen::Lower>().toDenseMatrix() - scatterReference.triangularView<Eigen::Lower>().toDenseMatrix();
+			return difference.norm() / scatterReference.triangularView<Eigen::Lower>().toDenseMatrix().norm();
+		};
+
+		const Eigen::MatrixXd scatter = math::scatterMatrix(data, stats.mean, Eigen::VectorXd(ones.cast<double>()));
+		REQUIRE(scatterDeviation(scatter) < 1e-12);
+		REQUIRE(maxDeviation(math::pcaScatterMat(scatter, num_dims, params)) < 1e-10);
+
+		// float accumulation loses about seven orders of magnitude, which still bounds the components by 1e-5
+		const Eigen::MatrixXf scatterSingle = math::scatterMatrix(data, Eigen::VectorXf(stats.mean.cast<float>()), ones);
+		REQUIRE(scatterDeviation(scatterSingle.cast<double>()) < 1e-5);
+		REQUIRE(maxDeviation(math::pcaScatterMat(scatterSingle, num_dims, params).cast<double>()) < 1e-5);
+	}
+
+	SECTION("Refinement") {
+		params.refinementSteps = 2;
+		const Eigen::MatrixXd scatter = math::scatterMatrix(data, stats.mean, Eigen::VectorXd(ones.cast<double>()));
+		REQUIRE(maxDeviation(math::pcaScatterMat(scatter, 3, params)) < 1e-10);
+	}
+
+	SECTION("Mixed pca") {
+		params.precision = math::PRECISION::MIXED;
+		size_t num_comp = num_dims;
+		std::vector<float> transMixed, transSVD;
+		REQUIRE(math::pca(std::span<const float>(data.data(), data.size()), num_dims, transMixed, num_comp, math::PCA_ALG::COV, math::DATA_NORM::NONE, true, params));
+		REQUIRE(math::pca(std::span<const float>(data.data(), data.size()), num_dims, transSVD, num_comp, math::PCA_ALG::SVD, math::DATA_NORM::NONE));
+		REQUIRE(compStdAndStdMatrixAppr(transMixed, transSVD, num_dims, 0.001f));
+	}
+
+}
+
+/// Scalar type and storage order
+/// Test that double and column-major inputs are processed natively and agree with the float, row-major path
+TEST_CASE("Scalar type and storage order", "[PCA][COV][SVD][RANDOMIZED][MinMaxNorm]") {
+
+	std::vector<float> data_in;
+	fs::path fileNameDataIris = dataDir / "iris_data.bin";
+	bool readFileSuccess = readBinaryToStdVector(fileNameDataIris.string(), data_in);
+	REQUIRE(readFileSuccess == true);
+
+	const size_t num_dims = 4;
+	const size_t num_points = data_in.size() / num_dims;
+	const size_t num_comp = 2;
+
+	const std::vector<double> data_double(data_in.begin(), data_in.end());
+
+	for (const auto alg : { math::PCA_ALG::COV, math::PCA_ALG::SVD, math::PCA_ALG::RANDOMIZED })
+	{
+		size_t num_comp_float = num_comp, num_comp_double = num_comp;
+		std::vector<float> transFloat;
+		std::vector<double> transDouble;
+
+		REQUIRE(math::pca(data_in, num_dims, transFloat, num_comp_float, alg, math::DATA_NORM::MINMAX));
+		REQUIRE(math::pca(data_double, num_dims, transDouble, num_comp_double, alg, math::DATA_NORM::MINMAX));
+		REQUIRE(compStdAndStdMatrixAppr(transFloat, std::vector<float>(transDouble.begin(), transDouble.end()), num_comp));
+
+		// column-major input and output give the same projection as the row-major buffers
+		const Eigen::MatrixXd data_colMajor = math::mapRowMajor(data_double, num_dims);
+		Eigen::MatrixXd trans_colMajor(num_points, num_comp);
+		REQUIRE(math::pcaInto(data_colMajor, trans_colMajor, num_comp, alg, math::DATA_NORM::MINMAX));
+		REQUIRE(trans_colMajor.isApprox(math::mapRowMajor(transDouble, num_comp), 1e-6));
+	}
+
+}
+
+/// Cancellation
+/// Test that a cancelled token stops pca and the chunked kernels, and that a reset token computes as before
+TEST_CASE("Cancellation", "[PCA][COV][SVD][RANDOMIZED][CANCEL]") {
+
+	std::vector<float> data_in;
+	fs::path fileNameDataIris = dataDir / "iris_data.bin";
+	bool readFileSuccess = readBinaryToStdVector(fileNameDataIris.string(), data_in);
+	REQUIRE(readFileSuccess == true);
+
+	const size_t num_dims = 4;
+	const auto data = math::mapRowMajor(data_in, num_dims);
+
+	math::CancellationToken cancel;
+	cancel.cancel();
+
+	math::SolverParams params;
+	params.cancel = &cancel;
+
+	SECTION("Kernels throw") {
+		REQUIRE_THROWS_AS(math::columnStatistics(data, &cancel), math::Cancelled);
+		REQUIRE_THROWS_AS(math::scatterMatrix(data, &cancel), math::Cancelled);
+		REQUIRE_THROWS_AS(math::pcaRandomizedSVD(math::colwiseZeroMean(data), 2, params), math::Cancelled);
+	}
+
+	SECTION("Pca returns false") {
+		for (const auto alg : { math::PCA_ALG::COV, math::PCA_ALG::SVD, math::PCA_ALG::RANDOMIZED })
+		{
+			size_t num_comp = 2;
+			std::vector<float> trans;
+			REQUIRE_FALSE(math::pca(data_in, num_dims, trans, num_comp, alg, math::DATA_NORM::MINMAX, true, params));
+
+			cancel.reset();
+			REQUIRE(math::pca(data_in, num_dims, trans, num_comp, alg, math::DATA_NORM::MINMAX, true, params));
+			cancel.cancel();
+		}
+	}
+
+}
+
+/// Progress
+/// Test that pca reports its phases in order with fractions in [0, 1] for all algorithms
+TEST_CASE("Progress reporting", "[PCA][COV][SVD][RANDOMIZED][PROGRESS]") {
+
+	std::vector<float> data_in;
+	fs::path fileNameDataIris = dataDir / "iris_data.bin";
+	bool readFileSuccess = readBinaryToStdVector(fileNameDataIris.string(), data_in);
+	REQUIRE(readFileSuccess == true);
+
+	const size_t num_dims = 4;
+
+	for (const auto alg : { math::PCA_ALG::COV, math::PCA_ALG::SVD, math::PCA_ALG::RANDOMIZED })
+	{
+		std::vector<std::pair<math::PHASE, float>> reports;
+
+		math::SolverParams params;
+		params.progress = [&reports](math::PHASE phase, float fraction) { reports.emplace_back(phase, fraction); };
+
+		size_t num_comp = 2;
+		std::vector<float> trans;
+		REQUIRE(math::pca(data_in, num_dims, trans, num_comp, alg, math::DATA_NORM::MINMAX, true, params));
+
+		REQUIRE(!reports.empty());
+		REQUIRE(reports.front().first == math::PHASE::NORMALIZE);
+		REQUIRE(reports.back() == std::make_pair(math::PHASE::ORIENT, 1.0f));
+
+		for (size_t i = 0; i < reports.size(); i++)
+		{
+			REQUIRE(reports[i].second >= 0.0f);
+			REQUIRE(reports[i].second <= 1.0f);
+			if (i > 0)
+				REQUIRE(reports[i - 1].first <= reports[i].first);
+		}
+	}
+
+}
+
+/// Fitted model
+/// Test that PcaModel reproduces pca, that its eigenvalues are the variances of the projection and that batches project like the full data
+TEST_CASE("Fitted model", "[PCA][COV][SVD][RANDOMIZED][MinMaxNorm][MODEL]") {
+
+	std::vector<float> data_in;
+	fs::path fileNameDataIris = dataDir / "iris_data.bin";
+	bool readFileSuccess = readBinaryToStdVector(fileNameDataIris.string(), data_in);
+	REQUIRE(readFileSuccess == true);
+
+	const size_t num_dims = 4;
+	const size_t num_comp = 3;
+	const auto data = math::mapRowMajor(data_in, num_dims);
+
+	for (const auto alg : { math::PCA_ALG::COV, math::PCA_ALG::SVD, math::PCA_ALG::RANDOMIZED })
+	{
+		math::PcaModel<float> model;
+		model.fit(data, num_comp, alg, math::DATA_NORM::MINMAX);
+
+		REQUIRE(model.numComponents() == num_comp);
+		REQUIRE(model.numDims() == num_dims);
+		REQUIRE(model.numRows() == static_cast<size_t>(data.rows()));
+
+		const math::RowMajorMatrixXf trans = model.transform(data);
+
+		size_t num_comp_ref = num_comp;
+		std::vector<float> transRef;
+		REQUIRE(math::pca(data_in, num_dims, transRef, num_comp_ref, alg, math::DATA_NORM::MINMAX));
+		REQUIRE(compStdAndStdMatrixAppr(transRef, math::convertEigenMatrixToStdVector(trans), num_comp));
+
+		// eigenvalues are the sample variances along the components, in decreasing order
+		const Eigen::VectorXf variances = (trans.rowwise() - trans.colwise().mean()).colwise().squaredNorm() / static_cast<float>(trans.rows() - 1);
+		REQUIRE(model.eigenvalues().isApprox(variances, 1e-3f));
+		REQUIRE(std::is_sorted(model.eigenvalues().begin(), model.eigenvalues().end(), std::greater<>{}));
+
+		// a batch of rows projects onto the same values as in the full projection
+		const Eigen::Index first = 40, num_batch = 25;
+		math::RowMajorMatrixXf batch_out(num_batch, num_comp);
+		model.transform(data.middleRows(first, num_batch), batch_out);
+		REQUIRE(batch_out.isApprox(trans.middleRows(first, num_batch)));
+	}
+
+	SECTION("Explained variance") {
+		// the total variance is the trace of the covariance matrix of the normalized data, also if only few components are computed
+		const Eigen::MatrixXf normed = math::minMaxNormalization(Eigen::MatrixXf(data));
+		const Eigen::MatrixXf centered = math::colwiseZeroMean(normed);
+		const float totalVariance = centered.squaredNorm() / static_cast<float>(centered.rows() - 1);
+
+		for (const auto alg : { math::PCA_ALG::COV, math::PCA_ALG::SVD, math::PCA_ALG::RANDOMIZED })
+		{
+			math::PcaModel<float> model;
+			model.fit(data, num_comp, alg, math::DATA_NORM::MINMAX);
+
+			REQUIRE(std::abs(model.totalVariance() - totalVariance) < 1e-4f * totalVariance);
+			REQUIRE(model.explainedVarianceRatio().isApprox(model.eigenvalues() / totalVariance, 1e-4f));
+
+			const Eigen::VectorXf cumulative = model.cumulativeExplainedVarianceRatio();
+			REQUIRE(std::is_sorted(cumulative.begin(), cumulative.end()));
+			REQUIRE(cumulative(num_comp - 1) < 1.0f);
+
+			// with all components the whole variance is explained
+			math::PcaModel<float> modelFull;
+			modelFull.fit(data, num_dims, alg, math::DATA_NORM::MINMAX);
+			REQUIRE(std::abs(modelFull.cumulativeExplainedVarianceRatio()(num_dims - 1) - 1.0f) < 1e-4f);
+		}
+	}
+
+}
+
+/// Cached decomposition
+/// Test that projecting onto the leading components of a decomposition with all components equals a pca with fewer components
+TEST_CASE("Projection onto a cached decomposition", "[PCA][COV][SVD][MinMaxNorm][MODEL]") {
+
+	std::vector<float> data_in;
+	fs::path fileNameDataIris = dataDir / "iris_data.bin";
+	bool readFileSuccess = readBinaryToStdVector(fileNameDataIris.string(), data_in);
+	REQUIRE(readFileSuccess == true);
+
+	const size_t num_dims = 4;
+	const auto data = math::mapRowMajor(data_in, num_dims);
+
+	for (const auto alg : { math::PCA_ALG::COV, math::PCA_ALG::SVD })
+	{
+		math::PcaModel<float> model;
+		REQUIRE(math::pcaFit(model, data, num_dims, alg, math::DATA_NORM::MINMAX));
+
+		for (const size_t num_comp : { 1, 2, 3 })
+		{
+			math::RowMajorMatrixXf trans(data.rows(), num_comp);
+			REQUIRE(math::pcaInto(model, data, trans, true));
+			REQUIRE(model.numComponents() == num_dims);
+
+			size_t num_comp_ref = num_comp;
+			std::vector<float> transRef;
+			REQUIRE(math::pca(data_in, num_dims, transRef, num_comp_ref, alg, math::DATA_NORM::MINMAX));
+			REQUIRE(compStdAndStdMatrixAppr(transRef, math::convertEigenMatrixToStdVector(trans), num_comp));
+		}
+	}
+
+}
+
+/// Variance threshold
+/// Test that the number of components is chosen by the explained variance, for all algorithms
+TEST_CASE("Variance threshold", "[PCA][COV][SVD][RANDOMIZED][VARIANCE]") {
+
+	const Eigen::Index num_rows = 1000;
+	const Eigen::Index num_dims = 300;
+	const float fraction = 0.9f;
+
+	// standard deviations decay geometrically, the dimensions are mixed by a random rotation
+	std::mt19937 gen(5);
+	std::normal_distribution<float> dist(0.0f, 1.0f);
+	Eigen::MatrixXf latent(num_rows, num_dims);
+	for (Eigen::Index col = 0; col < num_dims; col++)
+		for (Eigen::Index row = 0; row < num_rows; row++)
+			latent(row, col) = std::pow(0.85f, static_cast<float>(col)) * dist(gen);
+
+	Eigen::MatrixXf rotation(num_dims, num_dims);
+	for (Eigen::Index col = 0; col < num_dims; col++)
+		for (Eigen::Index row = 0; row < num_dims; row++)
+			rotation(row, col) = dist(gen);
+	rotation = math::orthonormalBasis(rotation);
+
+	const math::RowMajorMatrixXf data = latent * rotation.transpose();
+
+	// reference from the full spectrum
+	math::PcaModel<float> modelFull;
+	modelFull.fit(data, num_dims, math::PCA_ALG::SVD, math::DATA_NORM::NONE);
+	const size_t num_comp_ref = math::numComponentsForVariance(modelFull.eigenvalues(), modelFull.totalVariance(), fraction);
+	REQUIRE(num_comp_ref > 1);
+	REQUIRE(num_comp_ref < static_cast<size_t>(num_dims));
+
+	// start with fewer components than needed such that the solvers have to grow them
+	math::SolverParams params;
+	params.varianceFraction = fraction;
+	params.initialComponents = 2;
+	REQUIRE(num_comp_ref > params.initialComponents);
+
+	SECTION("Eigenpairs") {
+		printLine("Variance threshold: eigenpairs");
+
+		const Eigen::MatrixXf centered = math::colwiseZeroMean(data);
+		const Eigen::MatrixXf covMat = centered.transpose() * centered / static_cast<float>(num_rows - 1);
+
+		Eigen::MatrixXf eigenvectors;
+		Eigen::VectorXf eigenvalues;
+		math::eigenpairsForVariance(covMat, num_dims, eigenvectors, eigenvalues, params);
+
+		REQUIRE(static_cast<size_t>(eigenvalues.size()) == num_comp_ref);
+		REQUIRE(eigenvectors.cols() == eigenvalues.size());
+		REQUIRE(eigenvalues.isApprox(modelFull.eigenvalues().head(num_comp_ref), 1e-3f));
+		REQUIRE(eigenvalues.sum() >= fraction * covMat.trace() * (1.0f - 1e-5f));
+		REQUIRE(eigenvalues.head(num_comp_ref - 1).sum() < fraction * covMat.trace());
+	}
+
+	SECTION("Eigenpairs beyond the partial eigensolver") {
+		printLine("Variance threshold: full eigendecomposition");
+
+		// slowly decaying spectrum: the first rounds use the partial eigensolver, the wanted eigenpairs then outgrow it
+		Eigen::VectorXf spectrum(num_dims);
+		for (Eigen::Index comp = 0; comp < num_dims; comp++)
+			spectrum[comp] = 1.0f / static_cast<float>(comp + 1);
+		const Eigen::MatrixXf covMat = rotation * spectrum.asDiagonal() * rotation.transpose();
+
+		const size_t num_comp_slow = math::numComponentsForVariance(spectrum, spectrum.sum(), fraction);
+		REQUIRE(math::usePartialEigensolver(num_dims, params.initialComponents, params));
+		REQUIRE_FALSE(math::usePartialEigensolver(num_dims, num_comp_slow, params));
+
+		Eigen::MatrixXf eigenvectors;
+		Eigen::VectorXf eigenvalues;
+		math::eigenpairsForVariance(covMat, num_dims, eigenvectors, eigenvalues, params);
+
+		REQUIRE(static_cast<size_t>(eigenvalues.size()) == num_comp_slow);
+		REQUIRE(eigenvectors.cols() == eigenvalues.size());
+		REQUIRE(eigenvalues.isApprox(spectrum.head(num_comp_slow), 1e-3f));
+		REQUIRE(math::subspaceAngle(eigenvectors, rotation.leftCols(num_comp_slow)) < 1e-2);
+
+		// the upper bound also applies to the full eigendecomposition
+		const size_t num_comp_bound = num_comp_slow / 2;
+		math::eigenpairsForVariance(covMat, num_comp_bound, eigenvectors, eigenvalues, params);
+		REQUIRE(static_cast<size_t>(eigenvalues.size()) == num_comp_bound);
+		REQUIRE(eigenvalues.isApprox(spectrum.head(num_comp_bound), 1e-3f));
+	}
+
+	SECTION("Fitted model") {
+		for (const auto alg : { math::PCA_ALG::COV, math::PCA_ALG::SVD, math::PCA_ALG::RANDOMIZED })
+		{
+			printLine("Variance threshold: fitted model");
+
+			math::PcaModel<float> model;
+			model.fit(data, num_dims, alg, math::DATA_NORM::NONE, params);
+
+			REQUIRE(model.numComponents() == num_comp_ref);
+			REQUIRE(model.cumulativeExplainedVarianceRatio()(num_comp_ref - 1) >= fraction * (1.0f - 1e-4f));
+		}
+	}
+
+	SECTION("Number of components") {
+		printLine("Variance threshold: pca");
+
+		// num_comp is the upper bound and returns the number of selected components
+		std::vector<float> data_in = math::convertEigenMatrixToStdVector(data);
+		std::vector<float> trans;
+		size_t num_comp = num_dims;
+		REQUIRE(math::pca(data_in, num_dims, trans, num_comp, math::PCA_ALG::COV, math::DATA_NORM::NONE, true, params));
+		REQUIRE(num_comp == num_comp_ref);
+		REQUIRE(trans.size() == static_cast<size_t>(num_rows) * num_comp_ref);
+
+		// a lower upper bound takes precedence
+		size_t num_comp_bound = num_comp_ref / 2;
+		REQUIRE(math::pca(data_in, num_dims, trans, num_comp_bound, math::PCA_ALG::COV, math::DATA_NORM::NONE, true, params));
+		REQUIRE(num_comp_bound == num_comp_ref / 2);
+	}
+
+}
+
+/// Memory estimate
+/// Test that the estimated working memory follows the dispatch of the algorithms
+TEST_CASE("Working memory estimate", "[PCA][COV][SVD][RANDOMIZED][MEMORY]") {
+
+	const size_t num_rows = 100'000;
+	const size_t num_dims = 500;
+	const size_t num_comp = 10;
+
+	const size_t cov = math::estimateWorkingBytes<float>(num_rows, num_dims, num_comp, math::PCA_ALG::COV);
+	const size_t svd = math::estimateWorkingBytes<float>(num_rows, num_dims, num_comp, math::PCA_ALG::SVD);
+	const size_t randomized = math::estimateWorkingBytes<float>(num_rows, num_dims, num_comp, math::PCA_ALG::RANDOMIZED);
+
+	// the covariance matrix does not copy the data, the others do
+	REQUIRE(cov < num_rows * num_dims * sizeof(float));
+	REQUIRE(svd >= 2 * num_rows * num_dims * sizeof(float));
+	REQUIRE(randomized >= num_rows * num_dims * sizeof(float));
+	REQUIRE(randomized < svd);
+
+	// mixed precision accumulates in double
+	math::SolverParams params;
+	params.precision = math::PRECISION::MIXED;
+	REQUIRE(math::estimateWorkingBytes<float>(num_rows, num_dims, num_comp, math::PCA_ALG::COV, params) > cov);
+
+	// wide data uses the Gram matrix, which grows with the number of rows
+	REQUIRE(math::estimateWorkingBytes<float>(200, 5000, num_comp, math::PCA_ALG::COV) < math::estimateWorkingBytes<float>(400, 5000, num_comp, math::PCA_ALG::COV));
+
+}
+
+/// Sampling
+/// Test the uniform and stratified row samples and that a fit on a sample finds the components of the full data
+TEST_CASE("Fit on a sample", "[PCA][COV][SAMPLE]") {
+
+	SECTION("Uniform sample") {
+		printLine("Sample: uniform");
+
+		const std::vector<Eigen::Index> sample = math::uniformSample(10'000, 500, 3);
+		REQUIRE(sample.size() == 500);
+		REQUIRE(std::adjacent_find(sample.begin(), sample.end(), std::greater_equal<>{}) == sample.end());	// strictly increasing
+		REQUIRE(sample.back() < 10'000);
+		REQUIRE(math::uniformSample(10'000, 500, 3) == sample);
+
+		// all rows if the sample is not smaller than the data
+		REQUIRE(math::uniformSample(20, 50).size() == 20);
+	}
+
+	SECTION("Sample of the plugin") {
+		printLine("Sample: strategy");
+
+		// the plugin resolves its setting and draws the rows with these functions
+		REQUIRE(math::resolveFitSample(math::FIT_SAMPLE::UNIFORM, 10'000, 500, false) == math::FIT_SAMPLE::UNIFORM);
+		REQUIRE(math::resolveFitSample(math::FIT_SAMPLE::UNIFORM, 10'000, 10'000, false) == math::FIT_SAMPLE::ALL_POINTS);
+		REQUIRE(math::resolveFitSample(math::FIT_SAMPLE::STRATIFIED, 10'000, 500, true) == math::FIT_SAMPLE::STRATIFIED);
+		REQUIRE(math::resolveFitSample(math::FIT_SAMPLE::STRATIFIED, 10'000, 500, false) == math::FIT_SAMPLE::UNIFORM);
+		REQUIRE(math::resolveFitSample(math::FIT_SAMPLE::ALL_POINTS, 10'000, 500, true) == math::FIT_SAMPLE::ALL_POINTS);
+
+		const std::vector<Eigen::Index> sample = math::fitSampleRows(math::FIT_SAMPLE::UNIFORM, 10'000, 500, {}, 3);
+		REQUIRE(sample == math::uniformSample(10'000, 500, 3));
+		REQUIRE(math::fitSampleRows(math::FIT_SAMPLE::UNIFORM, 10'000, 500, {}, 4) != sample);
+		REQUIRE(math::fitSampleRows(math::FIT_SAMPLE::UNIFORM, 500, 500).empty());
+
+		// stratified without a label per row falls back to the uniform sample
+		const std::vector<uint32_t> labels(10'000, 0);
+		REQUIRE(math::fitSampleRows(math::FIT_SAMPLE::STRATIFIED, 10'000, 500, labels, 3) == math::stratifiedSample(labels, 500, 3));
+		REQUIRE(math::fitSampleRows(math::FIT_SAMPLE::STRATIFIED, 10'000, 500, std::span(labels).first(100), 3) == sample);
+	}
+
+	SECTION("Stratified sample") {
+		printLine("Sample: stratified");
+
+		// strata of 70%, 20% and 10% of the rows and a single row, interleaved
+		std::vector<uint32_t> labels(10'001);
+		for (size_t row = 0; row < 10'000; row++)
+			labels[row] = (row % 10 < 7) ? 0 : (row % 10 < 9) ? 1 : 2;
+		labels[10'000] = 3;
+
+		const std::vector<Eigen::Index> sample = math::stratifiedSample(labels, 1'000, 3);
+		REQUIRE(sample.size() == 1'000);
+		REQUIRE(std::adjacent_find(sample.begin(), sample.end(), std::greater_equal<>{}) == sample.end());
+
+		std::vector<size_t> counts(4, 0);
+		for (const Eigen::Index row : sample)
+			counts[labels[row]]++;
+
+		REQUIRE(counts[3] == 1);
+		REQUIRE(counts[0] >= 699);
+		REQUIRE(counts[0] <= 700);
+		REQUIRE(counts[1] >= 199);
+		REQUIRE(counts[1] <= 200);
+		REQUIRE(counts[2] >= 99);
+		REQUIRE(counts[2] <= 100);
+	}
+
+	SECTION("Components") {
+		printLine("Sample: components");
+
+		const Eigen::Index num_rows = 50'000;
+		const Eigen::Index num_dims = 20;
+		const size_t num_comp = 3;
+
+		// the latent variances decay along the axes, a random rotation turns the axes into the known principal components
+		std::mt19937 gen(9);
+		std::normal_distribution<float> dist(0.0f, 1.0f);
+		Eigen::MatrixXf rotation(num_dims, num_dims);
+		for (Eigen::Index col = 0; col < num_dims; col++)
+			for (Eigen::Index row = 0; row < num_dims; row++)
+				rotation(row, col) = dist(gen);
+		rotation = math::orthonormalBasis(rotation);
+
+		math::RowMajorMatrixXf latent(num_rows, num_dims);
+		for (Eigen::Index row = 0; row < num_rows; row++)
+			for (Eigen::Index col = 0; col < num_dims; col++)
+				latent(row, col) = std::pow(0.6f, static_cast<float>(col)) * dist(gen) + 0.1f * static_cast<float>(col);
+		const math::RowMajorMatrixXf data = latent * rotation.transpose();
+		const Eigen::MatrixXf components_ref = rotation.leftCols(num_comp);
+
+		math::PcaModel<float> modelFull;
+		modelFull.fit(data, num_comp, math::PCA_ALG::COV, math::DATA_NORM::NONE);
+		REQUIRE(math::subspaceAngle(modelFull.components(), components_ref) < 0.05);
+
+		// the sample of the plugin finds the same components
+		const math::RowMajorMatrixXf sample = math::sampleRows(data, math::fitSampleRows(math::FIT_SAMPLE::UNIFORM, num_rows, 5'000, {}, 1));
+		REQUIRE(sample.rows() == 5'000);
+
+		math::PcaModel<float> modelSample;
+		modelSample.fit(sample, num_comp, math::PCA_ALG::COV, math::DATA_NORM::NONE);
+
+		REQUIRE(math::subspaceAngle(components_ref, modelSample.components()) < 0.1);
+		REQUIRE(math::subspaceAngle(modelFull.components(), modelSample.components()) < 0.1);
+
+		// a basis rotated by a known angle out of the subspace
+		const double angle = 0.3;
+		const Eigen::MatrixXd identity = Eigen::MatrixXd::Identity(num_dims, num_dims);
+		Eigen::MatrixXd rotated = identity.leftCols(2);
+		rotated.col(1) = std::cos(angle) * identity.col(1) + std::sin(angle) * identity.col(2);
+		REQUIRE(std::abs(math::subspaceAngle(identity.leftCols(2), rotated) - angle) < 1e-6);
+
+		// a rotation within the subspace does not change it
+		Eigen::MatrixXd mixed(num_dims, 2);
+		mixed.col(0) = (identity.col(0) + identity.col(1)) / std::sqrt(2.0);
+		mixed.col(1) = (identity.col(0) - identity.col(1)) / std::sqrt(2.0);
+		REQUIRE(math::subspaceAngle(identity.leftCols(2), mixed) < 1e-6);
+
+		// orthogonal subspaces
+		REQUIRE(std::abs(math::subspaceAngle(identity.leftCols(2), identity.rightCols(2)) - std::acos(0.0)) < 1e-9);
+	}
+
+}
+
+/// Live update
+/// Replacing rows of the accumulated statistics with a downdate and an update is the same as accumulating the changed data
+TEST_CASE("Live update", "[PCA][COV][LIVE]") {
+
+	const size_t num_rows = 1'000;
+	const size_t num_dims = 6;
+
+	std::mt19937 gen(5);
+	std::normal_distribution<float> dist(0.0f, 1.0f);
+	std::vector<float> data(num_rows * num_dims);
+	for (size_t row = 0; row < num_rows; row++)
+		for (size_t col = 0; col < num_dims; col++)
+			data[row * num_dims + col] = (1.0f + static_cast<float>(col)) * dist(gen) + static_cast<float>(col);
+
+	SECTION("Changed rows") {
+		printLine("Live update: changed rows");
+
+		std::vector<float> next = data;
+		next[3 * num_dims + 1] += 1.0f;
+		next[700 * num_dims + 5] -= 1.0f;
+		next.insert(next.end(), { 1, 2, 3, 4, 5, 6 });
+
+		const std::vector<Eigen::Index> rows = math::changedRows<float>(data, next, num_dims);
+		REQUIRE(rows == std::vector<Eigen::Index>{ 3, 700, static_cast<Eigen::Index>(num_rows) });
+
+		// removed rows are not part of next
+		REQUIRE(math::changedRows<float>(next, data, num_dims) == std::vector<Eigen::Index>{ 3, 700 });
+	}
+
+	SECTION("Downdate") {
+		printLine("Live update: rank-k downdate and update");
+
+		math::CovarianceAccumulator acc(num_dims);
+		acc.addChunk(data.data(), num_rows);
+
+		// change rows within the extrema of the data
+		std::vector<float> next = data;
+		const math::ColumnStatistics<float> stats = math::columnStatistics(math::mapRowMajor(data, num_dims));
+		std::vector<Eigen::Index> rows;
+		for (size_t row = 0; row < num_rows && rows.size() < 50; row++)
+		{
+			const Eigen::Map<const Eigen::VectorXf> values(data.data() + row * num_dims, num_dims);
+			if ((values.array() > stats.minVals.array()).all() && (values.array() < stats.maxVals.array()).all())
+				rows.push_back(static_cast<Eigen::Index>(row));
+		}
+
+		for (const Eigen::Index row : rows)
+			for (size_t col = 0; col < num_dims; col++)
+				next[row * num_dims + col] = 0.5f * next[row * num_dims + col] + 0.25f * static_cast<float>(col);
+
+		REQUIRE(math::changedRows<float>(data, next, num_dims) == rows);
+
+		const math::RowMajorMatrixXf oldRows = math::sampleRows(math::mapRowMajor(data, num_dims), rows);
+		const math::RowMajorMatrixXf newRows = math::sampleRows(math::mapRowMajor(next, num_dims), rows);
+		REQUIRE(acc.removeChunk(oldRows.data(), oldRows.rows()));
+		REQUIRE(acc.numRows() == num_rows - rows.size());
+		acc.addChunk(newRows.data(), newRows.rows());
+
+		math::CovarianceAccumulator reference(num_dims);
+		reference.addChunk(next.data(), num_rows);
+
+		REQUIRE(acc.numRows() == num_rows);
+		REQUIRE(acc.mean().isApprox(reference.mean(), 1e-9));
+		REQUIRE(acc.covariance().isApprox(reference.covariance(), 1e-9));
+
+		// the decomposition of the updated statistics is that of the changed data
+		size_t num_comp = 3;
+		size_t num_comp_ref = 3;
+		REQUIRE(acc.finalize(num_comp, math::DATA_NORM::NONE));
+		REQUIRE(reference.finalize(num_comp_ref, math::DATA_NORM::NONE));
+		REQUIRE(math::subspaceAngle(acc.components(), reference.components()) < 1e-3);
+	}
+
+	SECTION("Extrema") {
+		printLine("Live update: extrema of removed rows");
+
+		math::CovarianceAccumulator acc(num_dims);
+		acc.addChunk(data.data(), num_rows);
+
+		// the row that holds the minimum of the first dimension
+		const auto firstColumn = math::mapRowMajor(data, num_dims).col(0);
+		Eigen::Index minRow = 0;
+		firstColumn.minCoeff(&minRow);
+
+		REQUIRE_FALSE(acc.removeChunk(data.data() + minRow * num_dims, 1));
+		REQUIRE(acc.numRows() == num_rows - 1);
+
+		// removing all rows starts over
+		math::CovarianceAccumulator all(num_dims);
+		all.addChunk(data.data(), num_rows);
+		REQUIRE(all.removeChunk(data.data(), num_rows));
+		REQUIRE(all.numRows() == 0);
+	}
+
+}